@@ -0,0 +1,417 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#include <luma_encoder.h>
+#include <luma_decoder.h>
+#include "exr_interface.h"
+#include "luma_exception.h"
+#include "arg_parser.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+// Benchmark options
+struct BenchData
+{
+    BenchData() : frames(10), resolutions("720p,1080p,4k"), tmpDir("."), exr(true)
+    {}
+    
+    unsigned int frames;
+    std::string resolutions, tmpDir, outputFile;
+    bool exr;
+};
+
+// Timing of one pipeline stage
+struct StageTime
+{
+    StageTime(std::string n = "") : name(n), ns(0), count(0)
+    {}
+    
+    std::string name;
+    double ns;
+    unsigned int count;
+};
+
+class Timer
+{
+public:
+    void start() { m_start = std::chrono::steady_clock::now(); }
+    
+    // Stop the timer, and add the elapsed time to the stage
+    void stop(StageTime &stage, bool newFrame = true)
+    {
+        std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+        stage.ns += std::chrono::duration<double, std::nano>(stop - m_start).count();
+        if (newFrame)
+            stage.count++;
+    }
+    
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// Synthetic test frame, that is shifted horizontally between frames
+void syntheticFrame(LumaFrame &frame, LumaFrame &pattern, unsigned int f)
+{
+    frame.resize(pattern.width, pattern.height, pattern.channels);
+    
+    const unsigned int w = pattern.width, shift = (8*f) % w;
+    for (unsigned int c=0; c<pattern.channels; c++)
+        for (unsigned int y=0; y<pattern.height; y++)
+        {
+            const float *src = pattern.getChannel(c) + (size_t)y*w;
+            float *dest = frame.getChannel(c) + (size_t)y*w;
+            memcpy(dest, src + shift, (w-shift)*sizeof(float));
+            memcpy(dest + w - shift, src, shift*sizeof(float));
+        }
+}
+
+void copyFrame(LumaFrame &dest, LumaFrame &src)
+{
+    dest.resize(src.width, src.height, src.channels);
+    memcpy(dest.buffer, src.buffer, src.size()*sizeof(float));
+}
+
+// Run all stages at one resolution
+std::vector<StageTime> benchmark(const BenchData &bd, unsigned int w, unsigned int h)
+{
+    std::vector<StageTime> stages;
+    Timer timer;
+    
+    LumaFrame pattern, frame, work;
+    ExrInterface::testFrame(pattern, w, h);
+    
+    // Color transformations, in both directions
+    const LumaQuantizer::colorSpace_t cs[] = {LumaQuantizer::CS_LUV, LumaQuantizer::CS_RGB, 
+                                              LumaQuantizer::CS_YCBCR, LumaQuantizer::CS_XYZ};
+    const char *csNames[] = {"luv", "rgb", "ycbcr", "xyz"};
+    for (unsigned int c=0; c<4; c++)
+    {
+        LumaQuantizer quant;
+        quant.setQuantizer(LumaQuantizer::PTF_PQ, 11, cs[c], 8, 1e4f, 0.005f);
+        StageTime to(std::string("transform_to_") + csNames[c]),
+                  from(std::string("transform_from_") + csNames[c]);
+        
+        for (unsigned int f=0; f<bd.frames; f++)
+        {
+            syntheticFrame(work, pattern, f);
+            timer.start();
+            quant.transformColorSpace(&work, true, 1.0f);
+            timer.stop(to);
+            timer.start();
+            quant.transformColorSpace(&work, false, 1.0f);
+            timer.stop(from);
+        }
+        stages.push_back(to);
+        stages.push_back(from);
+    }
+    
+    // Quantization of encoded values
+    {
+        LumaQuantizer quant;
+        quant.setQuantizer(LumaQuantizer::PTF_PQ, 11, LumaQuantizer::CS_LUV, 8, 1e4f, 0.005f);
+        StageTime qs("quantize"), dqs("dequantize");
+        volatile float sink = 0.0f;
+        
+        // The codes from quantization are the input to dequantization
+        const size_t n = (size_t)w*h;
+        std::vector<float> codes(3*n);
+        
+        syntheticFrame(work, pattern, 0);
+        quant.transformColorSpace(&work, true, 1.0f);
+        for (unsigned int f=0; f<bd.frames; f++)
+        {
+            float sum = 0.0f;
+            timer.start();
+            for (unsigned int c=0; c<3; c++)
+            {
+                const float *ch = work.getChannel(c);
+                float *code = &codes[c*n];
+                for (size_t i=0; i<n; i++)
+                    code[i] = quant.quantize(ch[i], c);
+            }
+            timer.stop(qs);
+            
+            timer.start();
+            for (unsigned int c=0; c<3; c++)
+            {
+                const float *code = &codes[c*n];
+                for (size_t i=0; i<n; i++)
+                    sum += quant.dequantize(code[i], c);
+            }
+            timer.stop(dqs);
+            sink = sink + sum;
+        }
+        stages.push_back(qs);
+        stages.push_back(dqs);
+    }
+    
+    // Encoding, with default parameters
+    std::string videoFile = bd.tmpDir + "/luma_bench.mkv", muxFile = bd.tmpDir + "/luma_bench_mux.mkv";
+    const unsigned int keyInterval = 25;
+    {
+        LumaEncoder encoder;
+        LumaEncoderParams params = encoder.getParams();
+        params.keyframeInterval = keyInterval;
+        encoder.setParams(params);
+        encoder.initialize(videoFile.c_str(), w, h);
+        
+        LumaQuantizer quant;
+        quant.setQuantizer(params.ptf, params.ptfBitDepth, params.colorSpace, params.colorBitDepth, params.maxLum, params.minLum);
+        
+        StageTime setCh("set_vpx_channels"), enc("vp9_encode");
+        for (unsigned int f=0; f<bd.frames; f++)
+        {
+            syntheticFrame(frame, pattern, f);
+            quant.transformColorSpace(&frame, true, params.preScaling);
+            
+            timer.start();
+            encoder.setChannels(&frame);
+            timer.stop(setCh);
+            timer.start();
+            encoder.run();
+            timer.stop(enc);
+        }
+        encoder.finish();
+        
+        stages.push_back(setCh);
+        stages.push_back(enc);
+    }
+    
+    // Demuxing and muxing of the encoded stream
+    {
+        StageTime demux("mkv_demux"), mux("mkv_mux");
+        std::vector< std::vector<uint8> > packets;
+        
+        MkvInterface reader;
+        reader.openRead(videoFile.c_str());
+        while (1)
+        {
+            timer.start();
+            bool ok = reader.readFrame();
+            unsigned int sz = 0;
+            const uint8 *buf = ok ? reader.getFrame(sz) : NULL;
+            if (!ok)
+                break;
+            timer.stop(demux);
+            packets.push_back(std::vector<uint8>(buf, buf+sz));
+        }
+        
+        MkvInterface writer;
+        writer.openWrite(muxFile.c_str(), w, h, 1e4f, 0.005f);
+        writer.writeAttachments();
+        for (size_t i=0; i<packets.size(); i++)
+        {
+            timer.start();
+            writer.addFrame(&packets[i][0], packets[i].size(), i % keyInterval == 0);
+            timer.stop(mux);
+        }
+        timer.start();
+        writer.close(); // Writing of cues is included in the muxing time
+        timer.stop(mux, false);
+        
+        stages.push_back(demux);
+        stages.push_back(mux);
+        
+        remove(muxFile.c_str());
+    }
+    
+    // Decoding
+    {
+        LumaDecoder decoder;
+        decoder.initialize(videoFile.c_str());
+        
+        StageTime dec("vp9_decode"), getCh("get_vpx_channels");
+        for (unsigned int f=0; f<bd.frames; f++)
+        {
+            timer.start();
+            bool ok = decoder.run();
+            if (!ok)
+                break;
+            timer.stop(dec);
+            
+            timer.start();
+            decoder.getVpxChannels();
+            timer.stop(getCh);
+        }
+        
+        stages.push_back(dec);
+        stages.push_back(getCh);
+    }
+    remove(videoFile.c_str());
+    
+    // OpenEXR input/output, with default compression
+    if (bd.exr)
+    {
+        std::string exrFile = bd.tmpDir + "/luma_bench.exr";
+        StageTime wr("exr_write"), rd("exr_read");
+        for (unsigned int f=0; f<bd.frames; f++)
+        {
+            syntheticFrame(frame, pattern, f);
+            timer.start();
+            ExrInterface::writeFrame(exrFile.c_str(), frame);
+            timer.stop(wr);
+            
+            timer.start();
+            ExrInterface::readFrame(exrFile.c_str(), work);
+            timer.stop(rd);
+        }
+        remove(exrFile.c_str());
+        
+        stages.push_back(wr);
+        stages.push_back(rd);
+    }
+    
+    return stages;
+}
+
+// Parse parameter options from command line
+bool setParams(int argc, char* argv[], BenchData *bd)
+{
+    bool noExr = false;
+    
+    // Application usage info
+    std::string info = std::string("luma_bench -- Measure the throughput of each stage of the LumaHDRv pipeline\n\n") +
+                       std::string("Usage: luma_bench --frames <frames> --resolutions <720p,1080p,4k> --output <json_file>\n");
+    std::string postInfo = std::string("\nExample: luma_bench -f 20 -r 1080p -o bench.json\n\n") +
+                           std::string("Results are written as JSON, to stdout if no output file is specified.");
+    ArgParser argHolder(info, postInfo);
+    
+    argHolder.add(&bd->frames,      "--frames",      "-f", "Number of frames to process at each resolution", (unsigned int)(1), (unsigned int)(10000));
+    argHolder.add(&bd->resolutions, "--resolutions", "-r", "Comma separated list of resolutions (720p, 1080p, 4k or WxH)");
+    argHolder.add(&bd->tmpDir,      "--tmp-dir",     "-t", "Directory for temporary video and EXR files");
+    argHolder.add(&bd->outputFile,  "--output",      "-o", "Output JSON file");
+    argHolder.add(&noExr,           "--no-exr",      "-ne","Skip the OpenEXR input/output stages");
+    
+    if (!argHolder.read(argc, argv))
+        return 0;
+    
+    bd->exr = !noExr;
+    
+    return 1;
+}
+
+// Translate a resolution name to width and height
+bool getResolution(std::string res, unsigned int &w, unsigned int &h)
+{
+    std::transform(res.begin(), res.end(), res.begin(), ::tolower);
+    
+    if (res == "720p")
+    {
+        w = 1280; h = 720;
+    }
+    else if (res == "1080p")
+    {
+        w = 1920; h = 1080;
+    }
+    else if (res == "4k" || res == "2160p")
+    {
+        w = 3840; h = 2160;
+    }
+    else if (sscanf(res.c_str(), "%ux%u", &w, &h) != 2)
+        return false;
+    
+    return w > 0 && h > 0 && w % 2 == 0 && h % 2 == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    BenchData bd;
+    
+    try
+    {
+        if (!setParams(argc, argv, &bd))
+            return 1;
+        
+        FILE *out = stdout;
+        if (bd.outputFile.size() > 0 && (out = fopen(bd.outputFile.c_str(), "w")) == NULL)
+            throw LumaException("Unable to open output file");
+        
+        fprintf(out, "{\n  \"benchmark\": \"luma_bench\",\n  \"frames\": %u,\n  \"results\": [", bd.frames);
+        
+        size_t pos = 0;
+        bool first = true;
+        while (pos <= bd.resolutions.size())
+        {
+            size_t end = bd.resolutions.find(',', pos);
+            if (end == std::string::npos)
+                end = bd.resolutions.size();
+            std::string res = bd.resolutions.substr(pos, end-pos);
+            pos = end + 1;
+            
+            unsigned int w, h;
+            if (!getResolution(res, w, h))
+                throw ParserException(std::string("Invalid resolution '" + res + "'").c_str());
+            
+            fprintf(stderr, "Benchmarking %s (%ux%u)...\n", res.c_str(), w, h);
+            std::vector<StageTime> stages = benchmark(bd, w, h);
+            
+            fprintf(out, "%s\n    {\n      \"resolution\": \"%s\",\n      \"width\": %u,\n      \"height\": %u,\n      \"stages\": {",
+                    first ? "" : ",", res.c_str(), w, h);
+            for (size_t i=0; i<stages.size(); i++)
+            {
+                double ms = stages[i].count ? 1e-6*stages[i].ns/stages[i].count : 0.0;
+                fprintf(out, "%s\n        \"%s\": {\"frames\": %u, \"ms_per_frame\": %.4f, \"mpixels_per_s\": %.2f}",
+                        i ? "," : "", stages[i].name.c_str(), stages[i].count, ms, 
+                        ms > 0.0 ? 1e-3*w*h/ms : 0.0);
+            }
+            fprintf(out, "\n      }\n    }");
+            first = false;
+        }
+        
+        fprintf(out, "\n  ]\n}\n");
+        if (out != stdout)
+            fclose(out);
+    }
+    catch (ParserException &e)
+    {
+        fprintf(stderr, "\nluma_bench input error: %s\n", e.what());
+        return 1;
+    }
+    catch (std::exception &e)
+    {
+        fprintf(stderr, "\nluma_bench error: %s\n", e.what());
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * \class BatchEncoder
+ *
+ * \brief Concurrent encoding of a list of HDR videos, in one process.
+ *
+ * BatchEncoder encodes a number of jobs, each with an input EXR sequence,
+ * frame range, output file and encoding parameters. The jobs run on a fixed
+ * set of worker threads, so that the cores stay busy while other jobs read
+ * input or initialize. Each job has its own LumaEncoder, as the codec and the
+ * output are per stream. The frame buffers are shared between jobs through a
+ * LumaFramePool, and the EXR decompression threads are shared through the
+ * global OpenEXR thread pool.
+ *
+ * The jobs are scheduled longest first, estimated from the number of frames
+ * and the frame size, so that the short jobs fill up the workers at the end
+ * instead of a long job starting last.
+ *
+ *
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#ifndef BATCH_ENCODER_H
+#define BATCH_ENCODER_H
+
+#include "luma_encoder.h"
+#include "luma_frame_pool.h"
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+struct BatchJob
+{
+    BatchJob() : startFrame(1), stepFrame(1), endFrame(9999),
+                 width(0), height(0), count(0), frames(0), seconds(0.0), failed(false)
+    {}
+    
+    std::string input, output;
+    unsigned int startFrame, stepFrame, endFrame;
+    
+    // Encoder parameters, where 0 threads means the codec threads of the batch
+    LumaEncoderParams params;
+    
+    // Frame size and number of input frames, and the result of the encoding
+    unsigned int width, height, count, frames;
+    double seconds;
+    bool failed;
+    std::string error;
+};
+
+class BatchEncoder
+{
+public:
+    BatchEncoder(unsigned int workers = 0, unsigned int codecThreads = 0);
+    
+    void add(const BatchJob &job) { m_jobs.push_back(job); }
+    bool run();
+    
+    const std::vector<BatchJob> &jobs() const { return m_jobs; }
+    unsigned int workers() const { return m_workers; }
+    unsigned int codecThreads() const { return m_codecThreads; }
+    
+private:
+    void probe(BatchJob &job);
+    void worker();
+    void encode(BatchJob &job);
+    std::string fileName(const BatchJob &job, unsigned int ind);
+    
+    std::vector<BatchJob> m_jobs;
+    std::vector<size_t> m_order;
+    size_t m_next;
+    unsigned int m_workers, m_codecThreads, m_finished;
+    
+    LumaFramePool m_pool;
+    std::mutex m_mutex;
+};
+
+#endif //BATCH_ENCODER_H
@@ -55,9 +55,14 @@
 class ExrInterface
 {
 public:
-    static bool readFrame(const char *inputFile, LumaFrame &frame);
-    static bool writeFrame(const char *outputFile, LumaFrame &frame);
+    enum compression_t {EXR_NONE, EXR_ZIP, EXR_PIZ, EXR_DWAA};
+    
+    static bool readFrame(const char *inputFile, LumaFrame &frame, float *readTime = NULL);
+    static bool readSize(const char *inputFile, unsigned int &w, unsigned int &h);
+    static bool writeFrame(const char *outputFile, LumaFrame &frame,
+                           compression_t compression = EXR_ZIP, bool half = true);
     static bool testFrame(LumaFrame &frame, unsigned int w = 1280, unsigned int h = 720);
+    static void setThreadCount(unsigned int threads);
 };
 
 #endif //EXR_INTERFACE_H
@@ -0,0 +1,102 @@
+/**
+ * \class ExrReader
+ *
+ * \brief Prefetching reader for numbered OpenEXR frame sequences.
+ *
+ * ExrReader reads the frames of a numbered sequence ahead of time, on a set 
+ * of worker threads, and hands them out in order. Files further ahead are 
+ * announced to the operating system for read-ahead, to hide the latency of
+ * network file systems.
+ *
+ *
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#ifndef EXR_READER_H
+#define EXR_READER_H
+
+#include "exr_interface.h"
+#include "luma_frame.h"
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class ExrReader
+{
+public:
+    ExrReader(const char *pattern,
+              unsigned int startFrame, unsigned int stepFrame, unsigned int endFrame,
+              unsigned int threads = 2, unsigned int prefetch = 4);
+    ~ExrReader();
+    
+    bool readFrame(LumaFrame &frame, float *readTime = NULL);
+    
+    unsigned int queueDepth();
+    
+private:
+    enum slotState_t {SLOT_EMPTY, SLOT_READING, SLOT_READY, SLOT_FAILED};
+    
+    struct Slot
+    {
+        Slot() : state(SLOT_EMPTY), readTime(0.0f) {}
+        
+        slotState_t state;
+        LumaFrame frame;
+        float readTime;
+        std::string error;
+    };
+    
+    void worker();
+    std::string fileName(unsigned int ind);
+    void hint(unsigned int ind);
+    
+    std::string m_pattern;
+    unsigned int m_start, m_step, m_count;
+    unsigned int m_issued, m_consumed, m_prefetch;
+    bool m_stop;
+    
+    std::vector<Slot> m_slots;
+    std::vector<std::thread> m_threads;
+    
+    std::mutex m_mutex;
+    std::condition_variable m_slotAvailable, m_frameReady;
+};
+
+#endif //EXR_READER_H
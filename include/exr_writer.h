@@ -0,0 +1,100 @@
+/**
+ * \class ExrWriter
+ *
+ * \brief Write-behind queue for OpenEXR frames.
+ *
+ * ExrWriter takes over decoded frames and writes them to OpenEXR files on a
+ * pool of worker threads, so that compression and file output can run in 
+ * parallel with decoding. The number of frames in flight is bounded, and 
+ * frame buffers are recycled between writes.
+ *
+ *
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#ifndef EXR_WRITER_H
+#define EXR_WRITER_H
+
+#include "exr_interface.h"
+#include "luma_frame.h"
+#include "luma_frame_pool.h"
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class ExrWriter
+{
+public:
+    ExrWriter(unsigned int threads = 4, unsigned int queueSize = 8);
+    ~ExrWriter();
+    
+    void setCompression(ExrInterface::compression_t compression) { m_compression = compression; }
+    void setHalf(bool half) { m_half = half; }
+    
+    void writeFrame(const char *outputFile, LumaFrame &frame);
+    void finish();
+    
+    unsigned int queueDepth();
+    
+private:
+    struct Job
+    {
+        std::string file;
+        LumaFrame frame;
+    };
+    
+    void worker();
+    void rethrow();
+    
+    std::vector<std::thread> m_threads;
+    std::deque<Job> m_queue;
+    LumaFramePool m_pool;
+    
+    std::mutex m_mutex;
+    std::condition_variable m_jobAvailable, m_slotAvailable;
+    
+    unsigned int m_maxQueue, m_active;
+    bool m_stop, m_half;
+    ExrInterface::compression_t m_compression;
+    std::string m_error;
+};
+
+#endif //EXR_WRITER_H
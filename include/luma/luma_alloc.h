@@ -0,0 +1,158 @@
+/**
+ * \class LumaAllocPolicy
+ *
+ * \brief Memory allocation policy for frame buffers.
+ *
+ * LumaAllocPolicy specifies how the large buffers of frames and codec images
+ * are allocated. With transparent huge pages, the memory is mapped and marked
+ * with madvise(MADV_HUGEPAGE). With explicit huge pages, the memory is mapped
+ * from the huge page pool (MAP_HUGETLB), falling back to transparent huge 
+ * pages if the pool is exhausted. First-touch writes each page at allocation,
+ * so that the pages are placed on the NUMA node of the allocating thread and 
+ * no page faults are taken later on. Huge pages are only available on Linux.
+ *
+ *
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#ifndef LUMA_ALLOC_H
+#define LUMA_ALLOC_H
+
+#include <cstddef>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#define LUMA_ALIGNMENT 64
+#define LUMA_HUGE_PAGE_SIZE (2 << 20)
+
+struct LumaAllocPolicy
+{
+    enum pages_t {PAGES_DEFAULT, PAGES_HUGE, PAGES_HUGETLB};
+    
+    LumaAllocPolicy(pages_t p = PAGES_DEFAULT, bool ft = false) : 
+        pages(p), firstTouch(ft)
+    {}
+    
+    // Policy used for all frame and codec buffers
+    static LumaAllocPolicy &getDefault()
+    {
+        static LumaAllocPolicy policy;
+        return policy;
+    }
+    static void setDefault(const LumaAllocPolicy &policy) { getDefault() = policy; }
+    
+    pages_t pages;
+    bool firstTouch;
+};
+
+// Allocate memory aligned to at least LUMA_ALIGNMENT bytes. Returns NULL on
+// failure. 'mapped' is set if the memory has to be released with munmap
+inline void *lumaAlloc(size_t bytes, bool &mapped, 
+                       const LumaAllocPolicy &policy = LumaAllocPolicy::getDefault())
+{
+    void *ptr = NULL;
+    mapped = false;
+    
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (policy.pages != LumaAllocPolicy::PAGES_DEFAULT && bytes >= LUMA_HUGE_PAGE_SIZE)
+    {
+        size_t sz = (bytes + LUMA_HUGE_PAGE_SIZE - 1) & ~(size_t)(LUMA_HUGE_PAGE_SIZE - 1);
+        
+        if (policy.pages == LumaAllocPolicy::PAGES_HUGETLB)
+            ptr = mmap(NULL, sz, PROT_READ | PROT_WRITE, 
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        
+        if (ptr == NULL || ptr == MAP_FAILED)
+        {
+            ptr = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr != MAP_FAILED)
+                madvise(ptr, sz, MADV_HUGEPAGE);
+        }
+        
+        if (ptr == MAP_FAILED)
+            ptr = NULL;
+        else
+            mapped = true;
+    }
+#endif
+    
+    if (!mapped)
+    {
+#ifdef _WIN32
+        ptr = _aligned_malloc(bytes, LUMA_ALIGNMENT);
+#else
+        if (posix_memalign(&ptr, LUMA_ALIGNMENT, bytes) != 0)
+            ptr = NULL;
+#endif
+    }
+    
+    // Fault in the pages from this thread
+    if (ptr != NULL && policy.firstTouch)
+    {
+        volatile char *p = (volatile char*)ptr;
+        for (size_t i=0; i<bytes; i+=4096)
+            p[i] = 0;
+    }
+    
+    return ptr;
+}
+
+// Release memory allocated with lumaAlloc
+inline void lumaFree(void *ptr, size_t bytes, bool mapped)
+{
+    if (ptr == NULL)
+        return;
+    
+#ifndef _WIN32
+    if (mapped)
+    {
+        munmap(ptr, (bytes + LUMA_HUGE_PAGE_SIZE - 1) & ~(size_t)(LUMA_HUGE_PAGE_SIZE - 1));
+        return;
+    }
+    free(ptr);
+#else
+    (void)bytes; (void)mapped;
+    _aligned_free(ptr);
+#endif
+}
+
+#endif //LUMA_ALLOC_H
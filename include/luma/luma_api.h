@@ -0,0 +1,247 @@
+/**
+ * \brief C interface of the Luma HDRv encoder and decoder.
+ *
+ * The C interface wraps LumaEncoder and LumaDecoder behind opaque handles,
+ * plain structs and status codes, so that the libraries can be used from C,
+ * and through FFI from e.g. Python or Rust, without depending on the C++ ABI.
+ * No exceptions cross the interface; on failure a status code < 0, or NULL,
+ * is returned, and the message can be queried with luma_enc_last_error() or
+ * luma_dec_last_error() in the same thread.
+ *
+ * Frames are described by luma_image_t, which points to caller owned memory
+ * with linear RGB values as float or half, either planar or interleaved,
+ * with arbitrary row and channel strides. Any channels after the first three
+ * (e.g. alpha) are ignored by the encoder, and set to 1 by the decoder.
+ * luma_enc_push_frame() reads the caller's buffer directly, converting each
+ * row as it is transformed by the encoder, so that e.g. numpy arrays can be
+ * passed without an intermediate copy. luma_dec_next_frame() decodes to the
+ * decoder's own float frame, since the color transform runs in place, and
+ * converts it to the caller's buffer in one pass.
+ *
+ * The encoder functions are exported by libluma_encoder, and the decoder
+ * functions by libluma_decoder.
+ *
+ *
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#ifndef LUMA_API_H
+#define LUMA_API_H
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#  ifdef LUMA_API_BUILD
+#    define LUMA_API __declspec(dllexport)
+#  else
+#    define LUMA_API __declspec(dllimport)
+#  endif
+#else
+#  define LUMA_API __attribute__((visibility("default")))
+#endif
+
+/* Incremented when the interface changes in an incompatible way */
+#define LUMA_API_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct luma_encoder luma_encoder_t;
+typedef struct luma_decoder luma_decoder_t;
+
+typedef enum
+{
+    LUMA_OK = 0,
+    LUMA_END_OF_STREAM = 1,
+    LUMA_ERROR = -1,
+    LUMA_INVALID_ARGUMENT = -2
+} luma_status_t;
+
+/* Same values as LumaQuantizer::ptf_t and LumaQuantizer::colorSpace_t */
+typedef enum
+{
+    LUMA_PTF_PSI = 0,
+    LUMA_PTF_PQ = 1,
+    LUMA_PTF_LOG = 2,
+    LUMA_PTF_JND_HDRVDP = 3,
+    LUMA_PTF_LINEAR = 4
+} luma_ptf_t;
+
+typedef enum
+{
+    LUMA_CS_LUV = 0,
+    LUMA_CS_RGB = 1,
+    LUMA_CS_YCBCR = 2,
+    LUMA_CS_XYZ = 3
+} luma_color_space_t;
+
+typedef enum
+{
+    LUMA_FLOAT32 = 0,
+    LUMA_FLOAT16 = 1
+} luma_sample_type_t;
+
+typedef enum
+{
+    LUMA_PLANAR = 0,
+    LUMA_INTERLEAVED = 1
+} luma_layout_t;
+
+/*
+ * Frame in caller owned memory. Sample (x,y) of channel c is located at
+ *   planar:      data + c*channel_stride + y*row_stride + x*sample_size
+ *   interleaved: data + y*row_stride + (x*channels + c)*sample_size
+ * A stride of 0 means tightly packed.
+ */
+typedef struct
+{
+    void *data;
+    unsigned int width, height;
+    unsigned int channels;          /* number of channels in the buffer, >= 3 */
+    luma_sample_type_t type;
+    luma_layout_t layout;
+    size_t row_stride;              /* bytes between rows */
+    size_t channel_stride;          /* bytes between planes (planar only) */
+} luma_image_t;
+
+/*
+ * Encoding parameters. struct_size is set by luma_enc_params_init(), and 
+ * lets later versions of the library append members: parameters from an
+ * older caller are completed with the defaults.
+ */
+typedef struct
+{
+    size_t struct_size;             /* sizeof(luma_enc_params_t) of the caller */
+    luma_ptf_t ptf;
+    luma_color_space_t color_space;
+    unsigned int ptf_bit_depth, color_bit_depth;
+    unsigned int bit_depth, profile;
+    unsigned int quantizer_scale, bitrate, keyframe_interval;
+    float pre_scaling, min_lum, max_lum, fps;
+    int lossless;
+} luma_enc_params_t;
+
+/* Describe a tightly packed frame, with zero strides */
+static inline void luma_image_init(luma_image_t *image, void *data,
+                                   unsigned int width, unsigned int height, unsigned int channels,
+                                   luma_sample_type_t type, luma_layout_t layout)
+{
+    image->data = data;
+    image->width = width;
+    image->height = height;
+    image->channels = channels;
+    image->type = type;
+    image->layout = layout;
+    image->row_stride = 0;
+    image->channel_stride = 0;
+}
+
+
+/* === Encoding ============================================================= */
+
+/* Returns LUMA_API_VERSION of the library */
+LUMA_API int luma_enc_api_version(void);
+
+/* Set the default encoding parameters, same as LumaEncoderParams */
+LUMA_API void luma_enc_params_init(luma_enc_params_t *params);
+
+/* Create an encoder writing to a Matroska file. params can be NULL for the
+   defaults, or otherwise has to be set up with luma_enc_params_init().
+   Returns NULL on failure */
+LUMA_API luma_encoder_t *luma_enc_create(const char *output_file,
+                                         unsigned int width, unsigned int height,
+                                         const luma_enc_params_t *params);
+
+/* Output function, which returns 0 on failure */
+typedef int (*luma_write_fn)(void *user, const void *data, size_t size);
+
+/* Create an encoder passing the encoded video to a function as it is
+   written. The output is sequential, so the duration and seek head of the
+   video are not written */
+LUMA_API luma_encoder_t *luma_enc_create_callback(luma_write_fn write, void *user,
+                                                  unsigned int width, unsigned int height,
+                                                  const luma_enc_params_t *params);
+
+/* Encode one frame. The frame is only read, and can be reused when the call
+   returns */
+LUMA_API int luma_enc_push_frame(luma_encoder_t *enc, const luma_image_t *frame);
+
+/* Flush the encoder and close the output */
+LUMA_API int luma_enc_finish(luma_encoder_t *enc);
+
+/* Release the encoder. The encoding is finished first, if needed */
+LUMA_API void luma_enc_destroy(luma_encoder_t *enc);
+
+LUMA_API const char *luma_enc_last_error(void);
+
+
+/* === Decoding ============================================================= */
+
+/* Returns LUMA_API_VERSION of the library */
+LUMA_API int luma_dec_api_version(void);
+
+/* Create a decoder reading from a Matroska file. Returns NULL on failure */
+LUMA_API luma_decoder_t *luma_dec_create(const char *input_file);
+
+/* Create a decoder reading from memory. The memory is not copied, and needs
+   to be valid until the decoder is destroyed */
+LUMA_API luma_decoder_t *luma_dec_create_memory(const void *data, size_t size);
+
+/* Frame size, and frame rate (can be NULL) */
+LUMA_API int luma_dec_get_info(luma_decoder_t *dec,
+                               unsigned int *width, unsigned int *height, float *fps);
+
+/* Decode the next frame, and convert it to the caller's buffer, which has to
+   be of the size given by luma_dec_get_info(). The frame is decoded to a 
+   planar float frame of the decoder, where the color transform runs in 
+   place, and is then written to the buffer in one pass. Returns 
+   LUMA_END_OF_STREAM after the last frame */
+LUMA_API int luma_dec_next_frame(luma_decoder_t *dec, const luma_image_t *frame);
+
+/* Seek to a time in seconds. The next frame is the key frame closest to it */
+LUMA_API int luma_dec_seek(luma_decoder_t *dec, float seconds);
+
+LUMA_API void luma_dec_destroy(luma_decoder_t *dec);
+
+LUMA_API const char *luma_dec_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LUMA_API_H */
@@ -51,6 +51,9 @@
 
 #include "luma_quantizer.h"
 #include "mkv_interface.h"
+#include "luma_exception.h"
+#include "luma_stats.h"
+#include "luma_trace.h"
 
 #include "vpx_decoder.h"
 #include "vp8dx.h"
@@ -96,6 +99,7 @@ public:
     MkvInterface *getReader() { return &m_reader; }
     LumaFrame *getFrame() { return &m_frame; }
     bool initialized() { return m_initialized; }
+    LumaStats &getStats() { return m_stats; }
     
 protected:
     bool m_initialized;
@@ -103,6 +107,7 @@ protected:
     LumaQuantizer m_quant;
     MkvInterface m_reader;
     LumaFrame m_frame;
+    LumaStats m_stats;
 };
 
 
@@ -139,33 +144,38 @@ public:
     ~LumaDecoder();
 
     bool initialize(const char *inputFile, bool verbose = 0);
+    bool initialize(IOCallback *input, bool verbose = 0);
     bool run();
     LumaFrame *decode()
     {
+        LumaTraceScope trace("decode_frame", m_stats.frames());
         if (!run())
             return NULL;
-            
-        if (!m_frame.width)
+        
         {
-            m_frame.width = m_vpxFrame->d_w;
-            m_frame.height = m_vpxFrame->d_h;
-            m_frame.channels = 3;
-            m_frame.init();
+            LumaTraceScope traceStage("dequantize");
+            LumaStageTimer timer(m_stats, LumaStats::STAGE_QUANTIZE);
+            getVpxChannels();
         }
-        
-	    getVpxChannels();
-        
-        m_quant.transformColorSpace(&m_frame, false, m_params.preScaling);
+        {
+            LumaTraceScope traceStage("transform");
+            LumaStageTimer timer(m_stats, LumaStats::STAGE_TRANSFORM);
+            m_quant.transformColorSpace(&m_frame, false, m_params.preScaling);
+        }
+        m_stats.endFrame();
         
         return &m_frame;
     }
     
+    void getVpxChannels();
+    
     unsigned char **getBuffer() { return m_vpxFrame->planes; }
     LumaDecoderParams getParams() { return m_params; }
     void setParams(LumaDecoderParams params) { m_params = params; }
     
 private:
-    void getVpxChannels();
+    bool initializeCodec(const char *inputName, bool verbose);
+    void updateGeometry();
 
     vpx_codec_ctx_t m_codec;
     vpx_image_t *m_vpxFrame;
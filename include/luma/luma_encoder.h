@@ -52,6 +52,10 @@
 #include "luma_quantizer.h"
 #include "mkv_interface.h"
 #include "luma_frame.h"
+#include "luma_image.h"
+#include "luma_exception.h"
+#include "luma_stats.h"
+#include "luma_trace.h"
 
 #include "vpx_encoder.h"
 #include "vp8cx.h"
@@ -90,17 +94,28 @@ public:
         return true;
     }
     
+    virtual bool initialize(IOCallback *output, 
+                            const unsigned int w, const unsigned int h,
+                            const float ma, const float mi,
+                            bool seekable = true)
+    {
+        m_writer.openWrite(output, w, h, ma, mi, seekable);
+        return true;
+    }
+    
     virtual bool run() = 0;
     virtual void setChannels(LumaFrame *frame) = 0;
     virtual bool encode(LumaFrame *frame) = 0;
     virtual void finish() { m_writer.close(); };
     
     bool initialized() { return m_initialized; }
+    LumaStats &getStats() { return m_stats; }
     
 protected:
     bool m_initialized;
     LumaQuantizer m_quant;
     MkvInterface m_writer;
+    LumaStats m_stats;
 };
 
 
@@ -110,14 +125,57 @@ protected:
 struct LumaEncoderParams : LumaEncoderParamsBase
 {
     LumaEncoderParams() : 
-        bitrate(10000), profile(2), keyframeInterval(0), bitDepth(12), lossLess(false)
+        bitrate(10000), profile(2), keyframeInterval(0), maxKeyframeInterval(50), bitDepth(12), threads(6),
+        maxClusterSize(5120), sceneCutThreshold(0.2f), maxClusterDuration(5.0f), lossLess(false)
     {}
     
-    unsigned int bitrate, profile, keyframeInterval, bitDepth;
+    // With keyframeInterval 0, keyframes are placed at scene cuts, and at
+    // most maxKeyframeInterval frames apart. A sceneCutThreshold of 0
+    // disables the scene cut detection
+    unsigned int bitrate, profile, keyframeInterval, maxKeyframeInterval, bitDepth, threads;
+    
+    // Limits of the Matroska clusters, in KB and s, in addition to a new
+    // cluster at each keyframe. 0 disables a limit
+    unsigned int maxClusterSize;
+    float sceneCutThreshold, maxClusterDuration;
     bool lossLess;
 };
 
 
+/**
+ * \class LumaSceneCutDetector
+ *
+ * \brief Detection of scene cuts, for placement of keyframes.
+ *
+ * Each frame is compared with the previous one, on a copy of the quantized
+ * luma plane that is downsampled by averaging 8x8 blocks. A cut is detected
+ * when the fraction of the pixels that move between the 32 bins of the
+ * histograms of the copies is above the threshold, and the mean absolute
+ * difference of the pixels is above 5% of the code range. Camera and object
+ * motion mostly preserve the histogram, while the second condition avoids
+ * cuts where small changes of flat frames move pixels across bins.
+ *
+ */
+class LumaSceneCutDetector
+{
+public:
+    LumaSceneCutDetector() : m_threshold(0.2f) {}
+    
+    void setThreshold(float threshold) { m_threshold = threshold; }
+    
+    // Returns true if the frame starts a new scene. The luma plane holds
+    // values 0-maxValue, and the first frame is not a cut
+    bool detect(const vpx_image_t *img, unsigned int maxValue);
+    
+private:
+    template <typename T>
+    void downsample(const vpx_image_t *img, unsigned int maxValue);
+    
+    float m_threshold;
+    std::vector<float> m_current, m_previous, m_rowSums;
+};
+
+
 /**
  * \class LumaEncoder
  *
@@ -137,14 +195,53 @@ public:
     ~LumaEncoder();
 
     bool initialize(const char *outputFile, const unsigned int w, const unsigned int h, bool verbose = 0);
+    bool initialize(IOCallback *output, const unsigned int w, const unsigned int h, bool seekable = true, bool verbose = 0);
     bool run();
     void setChannels(LumaFrame *frame);
     bool encode(LumaFrame *frame)
     {
-        m_quant.transformColorSpace(frame, true, m_params.preScaling);
-        setChannels(frame);
+        LumaTraceScope trace("encode_frame", m_frameCount);
+        {
+            LumaTraceScope traceStage("transform");
+            LumaStageTimer timer(m_stats, LumaStats::STAGE_TRANSFORM);
+            m_quant.transformColorSpace(frame, true, m_params.preScaling);
+        }
+        {
+            LumaTraceScope traceStage("quantize");
+            LumaStageTimer timer(m_stats, LumaStats::STAGE_QUANTIZE);
+            setChannels(frame);
+        }
         
-        return run();
+        bool res = run();
+        m_stats.endFrame();
+        
+        return res;
+    }
+    
+    // Encoding of a frame in caller owned memory, which is not modified
+    bool encode(const LumaImageView &image)
+    {
+        if (!m_initialized)
+            throw LumaException("Encoder is not initialized");
+        if (image.width != m_rawFrame.d_w || image.height != m_rawFrame.d_h || image.channels < 3)
+            throw LumaException("Image size differs from the size of the video");
+        
+        LumaTraceScope trace("encode_frame", m_frameCount);
+        {
+            LumaTraceScope traceStage("transform");
+            LumaStageTimer timer(m_stats, LumaStats::STAGE_TRANSFORM);
+            m_quant.transformColorSpace(image, &m_frame, m_params.preScaling);
+        }
+        {
+            LumaTraceScope traceStage("quantize");
+            LumaStageTimer timer(m_stats, LumaStats::STAGE_QUANTIZE);
+            setChannels(&m_frame);
+        }
+        
+        bool res = run();
+        m_stats.endFrame();
+        
+        return res;
     }
     void finish();
     
@@ -152,6 +249,7 @@ public:
     void setParams(LumaEncoderParams params) { m_params = params; };
     
 private:
+    bool initializeCodec(const char *outputName, const unsigned int w, const unsigned int h, bool verbose);
     int encode_frame_vpx(vpx_codec_ctx_t *codec,
                          vpx_image_t *img,
                          int frame_index,
@@ -160,7 +258,15 @@ private:
     
     vpx_codec_ctx_t m_codec;
 	vpx_image_t m_rawFrame;
+    unsigned char *m_rawBuffer;
+    size_t m_rawBytes;
+    bool m_rawMapped;
 	unsigned int m_frameCount;
+    
+    LumaSceneCutDetector m_sceneCuts;
+    
+    // Transformed frame, when encoding from a LumaImageView
+    LumaFrame m_frame;
 	
     LumaEncoderParams m_params;
 };
@@ -3,7 +3,10 @@
  *
  * \brief Convenience structure for images.
  *
- * Convenience structure for Luma frames during encoding/decoding.
+ * Convenience structure for Luma frames during encoding/decoding. The pixels
+ * are stored as planar floats, in a 64 byte aligned buffer allocated according
+ * to the default LumaAllocPolicy. A frame owns its buffer, and can be moved 
+ * but not copied.
  *
  *
  * This file is part of the LumaHDRv package.
@@ -46,47 +49,118 @@
 #ifndef LUMAFRAME_H
 #define LUMAFRAME_H
 
+#include "luma_alloc.h"
+
 #include <cstddef>
+#include <utility>
 
 struct LumaFrame
 {
     LumaFrame(unsigned int w = 0, unsigned int h = 0, unsigned int c = 3) : 
-        height(h), width(w), channels(c), buffer(NULL)
+        height(h), width(w), channels(c), buffer(NULL), allocBytes(0), allocMapped(false)
     {
         if (height && width && channels)
             init();
     }
     
+    LumaFrame(LumaFrame &&other) : 
+        height(other.height), width(other.width), channels(other.channels), buffer(other.buffer),
+        allocBytes(other.allocBytes), allocMapped(other.allocMapped)
+    {
+        other.buffer = NULL;
+    }
+    
+    LumaFrame &operator=(LumaFrame &&other)
+    {
+        if (this != &other)
+        {
+            clear();
+            height = other.height;
+            width = other.width;
+            channels = other.channels;
+            buffer = other.buffer;
+            allocBytes = other.allocBytes;
+            allocMapped = other.allocMapped;
+            other.buffer = NULL;
+        }
+        return *this;
+    }
+    
+    LumaFrame(const LumaFrame&) = delete;
+    LumaFrame &operator=(const LumaFrame&) = delete;
+    
     ~LumaFrame() { clear(); }
     
     void clear()
     {
         if (buffer != NULL)
         {
-            delete[] buffer;
+            lumaFree(buffer, allocBytes, allocMapped);
             buffer = NULL;
         }
     }
     
     bool init()
     {
-        if (!height && !width && !channels)
+        if (!height || !width || !channels)
             return 0;
             
         clear();
         
-        buffer = new float[channels*height*width];
+        allocBytes = size()*sizeof(float);
+        buffer = (float*)lumaAlloc(allocBytes, allocMapped);
+        
+        return buffer != NULL;
+    }
+    
+    // Set the frame geometry. The buffer is only reallocated if the size changes
+    bool resize(unsigned int w, unsigned int h, unsigned int c = 3)
+    {
+        if (buffer != NULL && (size_t)w*h*c*sizeof(float) == allocBytes)
+        {
+            width = w;
+            height = h;
+            channels = c;
+            return 1;
+        }
         
-        return 1;
+        width = w;
+        height = h;
+        channels = c;
+        return init();
+    }
+    
+    void swap(LumaFrame &other)
+    {
+        std::swap(height, other.height);
+        std::swap(width, other.width);
+        std::swap(channels, other.channels);
+        std::swap(buffer, other.buffer);
+        std::swap(allocBytes, other.allocBytes);
+        std::swap(allocMapped, other.allocMapped);
+    }
+    
+    size_t size() const
+    {
+        return (size_t)channels*height*width;
     }
     
     float* getChannel(unsigned int c)
     {
-        return buffer + c*height*width;
+        return buffer + (size_t)c*height*width;
+    }
+    
+    const float* getChannel(unsigned int c) const
+    {
+        return buffer + (size_t)c*height*width;
     }
     
     unsigned int height, width, channels;
     float *buffer;
+    
+    // Size and type of the allocation, for releasing the buffer
+    size_t allocBytes;
+    bool allocMapped;
 };
 
 #endif //LUMAFRAME_H
@@ -0,0 +1,119 @@
+/**
+ * \class LumaFramePool
+ *
+ * \brief Recycling of frame buffers.
+ *
+ * LumaFramePool keeps frames that are no longer in use, so that their buffers
+ * can be handed out again to frames of the same size. This avoids allocation
+ * and page faults for each frame in the encoding/decoding loops. The pool is
+ * thread safe.
+ *
+ *
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#ifndef LUMAFRAME_POOL_H
+#define LUMAFRAME_POOL_H
+
+#include "luma_frame.h"
+#include "luma_exception.h"
+
+#include <vector>
+#include <mutex>
+
+class LumaFramePool
+{
+public:
+    LumaFramePool(unsigned int maxFrames = 8) : m_maxFrames(maxFrames)
+    {}
+    
+    // Get a frame of the specified size, with a recycled buffer if available
+    LumaFrame acquire(unsigned int w, unsigned int h, unsigned int c = 3)
+    {
+        LumaFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            size_t sz = (size_t)w*h*c;
+            for (size_t i=0; i<m_frames.size(); i++)
+                if (m_frames[i].size() == sz)
+                {
+                    frame = std::move(m_frames[i]);
+                    m_frames.erase(m_frames.begin() + i);
+                    break;
+                }
+        }
+        
+        if (!frame.resize(w, h, c))
+            throw LumaException("Cannot allocate memory for frame");
+        
+        return frame;
+    }
+    
+    // Hand a frame back to the pool. The oldest frame is freed if the pool is full
+    void release(LumaFrame &&frame)
+    {
+        LumaFrame released(std::move(frame));
+        if (released.buffer == NULL)
+            return;
+        
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_maxFrames == 0)
+            return;
+        if (m_frames.size() >= m_maxFrames)
+            m_frames.erase(m_frames.begin());
+        m_frames.push_back(std::move(released));
+    }
+    
+    void clear()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_frames.clear();
+    }
+    
+    size_t size()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_frames.size();
+    }
+    
+private:
+    std::vector<LumaFrame> m_frames;
+    unsigned int m_maxFrames;
+    std::mutex m_mutex;
+};
+
+#endif //LUMAFRAME_POOL_H
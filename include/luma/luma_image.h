@@ -0,0 +1,207 @@
+/**
+ * \class LumaImageView
+ *
+ * \brief Description of a frame in caller owned memory.
+ *
+ * LumaImageView describes RGB(A) frames that are not stored as the planar
+ * float channels of LumaFrame, e.g. interleaved half float frames with row
+ * padding from a renderer. The view is read one row at a time, and the
+ * encoder converts each row while it is transformed to the color space of the
+ * encoding (see LumaEncoder::encode()), without modifying or copying the
+ * frame first.
+ *
+ * Half floats are converted without depending on OpenEXR, with rounding to
+ * nearest even, and handling of subnormals, infinity and NaN.
+ *
+ *
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#ifndef LUMA_IMAGE_H
+#define LUMA_IMAGE_H
+
+#include "luma_api.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+inline float lumaHalfToFloat(uint16_t h)
+{
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exponent = (h >> 10) & 0x1f, mantissa = h & 0x3ff;
+    uint32_t bits;
+    float f;
+    
+    if (exponent == 0x1f) // infinity or NaN
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    else if (exponent) // normalized
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    else // zero or subnormal, mantissa*2^-24
+    {
+        f = mantissa * (1.0f/16777216.0f);
+        memcpy(&bits, &f, sizeof(float));
+        bits |= sign;
+    }
+    
+    memcpy(&f, &bits, sizeof(float));
+    return f;
+}
+
+inline uint16_t lumaFloatToHalf(float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(float));
+    uint16_t sign = (bits >> 16) & 0x8000;
+    uint32_t mag = bits & 0x7fffffff;
+    
+    if (mag > 0x7f800000) // NaN
+        return sign | 0x7e00;
+    if (mag >= 0x477ff000) // overflow, or infinity
+        return sign | 0x7c00;
+    if (mag < 0x38800000) // subnormal, or zero
+    {
+        memcpy(&f, &mag, sizeof(float));
+        return sign | (uint16_t)lrintf(f * 16777216.0f);
+    }
+    
+    // Re-bias exponent, and round to nearest even
+    mag -= 0x38000000;
+    mag += 0xfff + ((mag >> 13) & 1);
+    return sign | (uint16_t)(mag >> 13);
+}
+
+struct LumaImageView
+{
+    enum sample_t {SAMPLE_FLOAT32, SAMPLE_FLOAT16};
+    enum layout_t {LAYOUT_PLANAR, LAYOUT_INTERLEAVED};
+    
+    // Sample (x,y) of channel c is located at
+    //   planar:      data + c*channelStride + y*rowStride + x*sampleBytes
+    //   interleaved: data + y*rowStride + (x*channels + c)*sampleBytes
+    // A stride of 0 means tightly packed
+    LumaImageView(const void *d = NULL, unsigned int w = 0, unsigned int h = 0, unsigned int c = 3,
+                  sample_t t = SAMPLE_FLOAT32, layout_t l = LAYOUT_PLANAR,
+                  size_t rs = 0, size_t cs = 0) :
+        data(d), width(w), height(h), channels(c), type(t), layout(l), rowStride(rs), channelStride(cs)
+    {}
+    
+    size_t sampleBytes() const
+    {
+        return type == SAMPLE_FLOAT16 ? sizeof(uint16_t) : sizeof(float);
+    }
+    
+    size_t pixelBytes() const
+    {
+        return layout == LAYOUT_INTERLEAVED ? channels*sampleBytes() : sampleBytes();
+    }
+    
+    size_t rowBytes() const
+    {
+        return rowStride ? rowStride : width*pixelBytes();
+    }
+    
+    size_t channelBytes() const
+    {
+        if (layout == LAYOUT_INTERLEAVED)
+            return sampleBytes();
+        return channelStride ? channelStride : height*rowBytes();
+    }
+    
+    const char *sample(unsigned int c, unsigned int x, unsigned int y) const
+    {
+        return (const char*)data + c*channelBytes() + y*rowBytes() + x*pixelBytes();
+    }
+    
+    // Row y of channel c as floats. Contiguous and aligned float rows are
+    // returned directly, and other rows are converted to buffer
+    const float *row(unsigned int c, unsigned int y, float *buffer) const
+    {
+        const char *src = sample(c, 0, y);
+        const size_t stride = pixelBytes();
+        
+        if (type == SAMPLE_FLOAT32 && stride == sizeof(float) && !((uintptr_t)src % sizeof(float)))
+            return (const float*)src;
+        
+        if (type == SAMPLE_FLOAT32)
+            for (unsigned int x = 0; x < width; x++)
+                memcpy(buffer + x, src + x*stride, sizeof(float));
+        else
+            for (unsigned int x = 0; x < width; x++)
+            {
+                uint16_t v;
+                memcpy(&v, src + x*stride, sizeof(uint16_t));
+                buffer[x] = lumaHalfToFloat(v);
+            }
+        
+        return buffer;
+    }
+    
+    const void *data;
+    unsigned int width, height, channels;
+    sample_t type;
+    layout_t layout;
+    size_t rowStride, channelStride;
+};
+
+// View of a frame of the C interface (see luma_api.h)
+inline LumaImageView lumaImageView(const luma_image_t &image)
+{
+    return LumaImageView(image.data, image.width, image.height, image.channels,
+                         image.type == LUMA_FLOAT16 ? LumaImageView::SAMPLE_FLOAT16 : LumaImageView::SAMPLE_FLOAT32,
+                         image.layout == LUMA_INTERLEAVED ? LumaImageView::LAYOUT_INTERLEAVED : LumaImageView::LAYOUT_PLANAR,
+                         image.row_stride, image.channel_stride);
+}
+
+// Check that a frame of the C interface can be used for a video of the given size
+inline const char *lumaImageError(const luma_image_t *image, unsigned int width, unsigned int height)
+{
+    if (image == NULL || image->data == NULL)
+        return "No image data";
+    if (image->width != width || image->height != height)
+        return "Image size differs from the size of the video";
+    if (image->channels < 3)
+        return "Image needs at least 3 channels";
+    if (image->type != LUMA_FLOAT32 && image->type != LUMA_FLOAT16)
+        return "Unknown image sample type";
+    if (image->layout != LUMA_PLANAR && image->layout != LUMA_INTERLEAVED)
+        return "Unknown image layout";
+    return NULL;
+}
+
+#endif //LUMA_IMAGE_H
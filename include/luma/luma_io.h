@@ -0,0 +1,207 @@
+/**
+ * \class LumaMemoryWriter, LumaMemoryReader, LumaCallbackWriter
+ *
+ * \brief Encoding to, and decoding from, memory or a user callback.
+ *
+ * The classes implement the IOCallback interface of libebml, and can be
+ * passed to LumaEncoder::initialize() and LumaDecoder::initialize() in place
+ * of a file name. LumaMemoryWriter stores the encoded video in a growable
+ * buffer, LumaMemoryReader reads a video from a span of memory owned by the
+ * caller, and LumaCallbackWriter passes the encoded video to a user function
+ * as it is written, e.g. for network streaming.
+ *
+ * LumaCallbackWriter cannot seek, and the encoder should then be initialized
+ * with seekable = false. The segment size, duration and seek head, which are
+ * normally updated when the encoding is finished, are then left unset. The
+ * video can still be decoded, but seeking requires the cues at the end.
+ *
+ *
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#ifndef LUMA_IO_H
+#define LUMA_IO_H
+
+#include "luma_exception.h"
+
+#include "ebml/IOCallback.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+using namespace LIBEBML_NAMESPACE;
+
+// Growable memory buffer, that the encoded video is written to
+class LumaMemoryWriter : public IOCallback
+{
+public:
+    LumaMemoryWriter(size_t reserve = 1 << 20) : m_pos(0)
+    {
+        m_data.reserve(reserve);
+    }
+    
+    uint32 read(void *buffer, size_t size)
+    {
+        size = std::min(size, m_data.size() - std::min(m_pos, m_data.size()));
+        memcpy(buffer, m_data.data() + m_pos, size);
+        m_pos += size;
+        return (uint32)size;
+    }
+    
+    size_t write(const void *buffer, size_t size)
+    {
+        // The vector grows geometrically, so that appending is amortized O(1)
+        if (m_pos + size > m_data.size())
+            m_data.resize(m_pos + size);
+        memcpy(m_data.data() + m_pos, buffer, size);
+        m_pos += size;
+        return size;
+    }
+    
+    void setFilePointer(int64 offset, seek_mode mode = seek_beginning)
+    {
+        if (mode == seek_current)
+            offset += m_pos;
+        else if (mode == seek_end)
+            offset += m_data.size();
+        if (offset < 0)
+            throw LumaException("Invalid seek in memory buffer");
+        m_pos = (size_t)offset;
+    }
+    
+    uint64 getFilePointer() { return m_pos; }
+    void close() {}
+    
+    const uint8_t *data() const { return m_data.data(); }
+    size_t size() const { return m_data.size(); }
+    
+    // Move the encoded video out of the writer
+    void release(std::vector<uint8_t> &data)
+    {
+        data.swap(m_data);
+        m_data.clear();
+        m_pos = 0;
+    }
+
+private:
+    std::vector<uint8_t> m_data;
+    size_t m_pos;
+};
+
+// Encoded video in memory owned by the caller, that is read by the decoder.
+// The memory needs to be valid for the lifetime of the decoder
+class LumaMemoryReader : public IOCallback
+{
+public:
+    LumaMemoryReader(const void *data, size_t size) :
+        m_data((const uint8_t*)data), m_size(size), m_pos(0)
+    {}
+    
+    uint32 read(void *buffer, size_t size)
+    {
+        size = std::min(size, m_size - std::min(m_pos, m_size));
+        memcpy(buffer, m_data + m_pos, size);
+        m_pos += size;
+        return (uint32)size;
+    }
+    
+    size_t write(const void *, size_t)
+    {
+        throw LumaException("Memory reader cannot be written");
+    }
+    
+    void setFilePointer(int64 offset, seek_mode mode = seek_beginning)
+    {
+        if (mode == seek_current)
+            offset += m_pos;
+        else if (mode == seek_end)
+            offset += m_size;
+        if (offset < 0 || (uint64)offset > m_size)
+            throw LumaException("Invalid seek in memory buffer");
+        m_pos = (size_t)offset;
+    }
+    
+    uint64 getFilePointer() { return m_pos; }
+    void close() {}
+
+private:
+    const uint8_t *m_data;
+    size_t m_size, m_pos;
+};
+
+// Sequential output, through a user function. The function returns false on
+// failure, which aborts the encoding
+class LumaCallbackWriter : public IOCallback
+{
+public:
+    typedef std::function<bool(const void *buffer, size_t size)> callback_t;
+    
+    LumaCallbackWriter(callback_t callback) : m_callback(callback), m_pos(0)
+    {}
+    
+    uint32 read(void *, size_t)
+    {
+        throw LumaException("Callback writer cannot be read");
+    }
+    
+    size_t write(const void *buffer, size_t size)
+    {
+        if (!m_callback(buffer, size))
+            throw LumaException("Failed to write to output callback");
+        m_pos += size;
+        return size;
+    }
+    
+    // Only seeking to the current position is possible
+    void setFilePointer(int64 offset, seek_mode mode = seek_beginning)
+    {
+        if ((mode == seek_beginning && (uint64)offset != m_pos) || (mode != seek_beginning && offset != 0))
+            throw LumaException("Callback writer cannot seek");
+    }
+    
+    uint64 getFilePointer() { return m_pos; }
+    void close() {}
+
+private:
+    callback_t m_callback;
+    uint64 m_pos;
+};
+
+#endif //LUMA_IO_H
@@ -0,0 +1,130 @@
+/**
+ * \class LumaMetaData
+ *
+ * \brief Meta data of a HDR video, stored as a versioned record.
+ *
+ * LumaMetaData holds the parameters needed for decoding (transfer function,
+ * color space, bit depths, scaling and luminance range) together with the
+ * mapping of the transfer function. It writes and reads them as one versioned
+ * record in a Matroska attachment, and reads the separate attachments of
+ * files written before the record was introduced.
+ *
+ *
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#ifndef LUMA_META_DATA_H
+#define LUMA_META_DATA_H
+
+#include "luma_quantizer.h"
+#include "mkv_interface.h"
+
+#include <stdint.h>
+#include <vector>
+
+// Attachment UID of the meta data record. Files written before the record
+// store each field in a separate attachment, with UIDs 430-436
+#define LUMA_META_DATA_UID 437
+
+/**
+ * \class LumaMetaData
+ *
+ * \brief Meta data of a HDR video, needed for decoding.
+ *
+ * The meta data is stored in a Matroska attachment, as one versioned record
+ * with the fields in little-endian byte order:
+ *
+ *   offset  size  field
+ *   0       4     "LHDR"
+ *   4       2     version, where a new major version (high byte) breaks
+ *                 compatibility and a new minor version only appends fields
+ *   6       2     header size, i.e. the offset of the mapping
+ *   8       1     transfer function (LumaQuantizer::ptf_t)
+ *   9       1     color space (LumaQuantizer::colorSpace_t)
+ *   10      1     PTF bit depth
+ *   11      1     color bit depth
+ *   12      4     pre-scaling (float)
+ *   16      4     max luminance (float)
+ *   20      4     min luminance (float)
+ *   24      1     encoding of the mapping (mapping_t)
+ *   25      3     reserved
+ *   28      4     number of values of the mapping, 2^(PTF bit depth), or 0
+ *                 if the mapping is not stored
+ *   32      4     size of the mapping in bytes
+ *   36      -     mapping
+ *
+ * The mapping of an analytic PTF (PQ, log and linear) is not stored, but is
+ * regenerated from the parameters when decoding. A tabulated mapping is
+ * stored as the second order differences of the bit patterns of its float
+ * values, which are small for a smooth and increasing mapping, and are coded
+ * as zigzag varints. Trailing repetitions of the last value are not stored.
+ * This is lossless, and about 3 times smaller than the float values at 12
+ * bits. Version 2.0 introduced these encodings, while version 1.0 always
+ * stored the float values, which can still be read.
+ *
+ */
+class LumaMetaData
+{
+public:
+    enum mapping_t {MAPPING_FLOAT, MAPPING_PARAMETRIC, MAPPING_DELTA};
+    
+    LumaMetaData();
+    
+    // Serialize to, or parse, a record. Parsing returns false if the record
+    // is not valid, and throws if it has an unsupported major version
+    void serialize(std::vector<uint8_t> &record) const;
+    bool deserialize(const uint8_t *record, size_t size);
+    
+    // Parse an attachment of a file written before the record
+    bool deserializeLegacy(unsigned int uid, const uint8_t *buffer, size_t size);
+    
+    // Add the record as an attachment of a file opened for writing, or read
+    // it (or the legacy attachments) from an opened file. Reading returns
+    // false if the meta data is not found
+    void addAttachment(MkvInterface &writer) const;
+    bool readAttachments(MkvInterface &reader);
+    
+    LumaQuantizer::ptf_t ptf;
+    LumaQuantizer::colorSpace_t colorSpace;
+    unsigned int ptfBitDepth, colorBitDepth;
+    float preScaling, maxLum, minLum;
+    
+    // Empty if the mapping is regenerated from the parameters
+    std::vector<float> mapping;
+};
+
+#endif //LUMA_META_DATA_H
@@ -0,0 +1,147 @@
+/**
+ * \class LumaMetrics
+ *
+ * \brief Quality metrics of decoded HDR frames.
+ *
+ * LumaMetrics compares HDR frames with reference frames in absolute
+ * luminance (cd/m^2), without any intermediate files. The metrics are PSNR of
+ * PU21 encoded luminance (banding + glare variant), PSNR of log luminance,
+ * SSIM of PU21 encoded luminance and the mean color difference Delta E ITP
+ * (ITU-R BT.2124). The frames are assumed to have linear Rec.709 primaries,
+ * as output by LumaDecoder. The computations are split over rows, in a number
+ * of threads, and the inner loops operate on contiguous float planes so that
+ * they can be vectorized by the compiler.
+ *
+ * Results are returned for each frame, and accumulated over all frames
+ * compared since the last reset.
+ *
+ *
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#ifndef LUMA_METRICS_H
+#define LUMA_METRICS_H
+
+#include "luma_frame.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+struct LumaMetricsResult
+{
+    LumaMetricsResult() : puPsnr(0.0), logPsnr(0.0), puSsim(0.0), deltaEitp(0.0)
+    {}
+    
+    double puPsnr, logPsnr, puSsim, deltaEitp;
+};
+
+class LumaMetrics
+{
+public:
+    LumaMetrics(unsigned int threads = 0, float minLum = 0.005f, float maxLum = 1e4f);
+    
+    LumaMetricsResult compare(const LumaFrame &reference, const LumaFrame &test);
+    
+    void reset();
+    unsigned int frames() const { return m_frames; }
+    LumaMetricsResult mean() const;
+    
+    std::string json(const LumaMetricsResult &res) const;
+    
+    static float puEncode(float Y);
+    static float pqEncode(float Y);
+
+private:
+    // Table of a function over a range of positive values, indexed by the
+    // exponent and upper mantissa bits of the input (256 entries per octave),
+    // with linear interpolation in between
+    class LogTable
+    {
+    public:
+        void init(float (*fn)(float), float mn, float mx);
+        
+        float operator()(float x) const
+        {
+            x = x < m_min ? m_min : (x > m_max ? m_max : x);
+            uint32_t bits;
+            memcpy(&bits, &x, sizeof(float));
+            uint32_t i = (bits >> 15) - m_base;
+            float frac = (bits & 0x7fff) * (1.0f/32768.0f);
+            return m_table[i] + frac*(m_table[i+1] - m_table[i]);
+        }
+        
+    private:
+        std::vector<float> m_table;
+        float m_min, m_max;
+        uint32_t m_base;
+    };
+    
+    // Partial sums of one range of rows
+    struct Sums
+    {
+        Sums() : puSse(0.0), logSse(0.0), ssim(0.0), deltaE(0.0), ssimPixels(0)
+        {}
+        
+        double puSse, logSse, ssim, deltaE;
+        size_t ssimPixels;
+    };
+    
+    void parallelRows(unsigned int rows, const std::function<void(unsigned int, unsigned int, Sums&)> &fn,
+                      Sums &total);
+    void pixelMetrics(const LumaFrame &reference, const LumaFrame &test,
+                      unsigned int y0, unsigned int y1, Sums &sums);
+    void ssimFilterRows(unsigned int y0, unsigned int y1);
+    void ssimRows(unsigned int y0, unsigned int y1, Sums &sums);
+    
+    unsigned int m_threads;
+    float m_minLum, m_maxLum, m_puPeak;
+    unsigned int m_width, m_height;
+    
+    // PU encoded luminance, and horizontally filtered SSIM statistics
+    std::vector<float> m_puRef, m_puTest, m_mu1, m_mu2, m_s11, m_s22, m_s12;
+    
+    LogTable m_puTable, m_pqTable, m_logTable;
+    
+    unsigned int m_frames;
+    size_t m_pixels;
+    double m_puSse, m_logSse, m_ssimSum, m_deltaESum;
+};
+
+#endif //LUMA_METRICS_H
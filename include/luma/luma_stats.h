@@ -0,0 +1,123 @@
+/**
+ * \class LumaStats
+ *
+ * \brief Timings and counters of the encoding/decoding pipeline.
+ *
+ * LumaStats accumulates the time spent in each stage of encoding/decoding 
+ * (color transformation, quantization, codec, muxing/demuxing and frame I/O),
+ * both in total and for the last frame. It also counts frames, compressed 
+ * bytes and keyframes, and keeps track of the depth of frame queues. Timing
+ * uses a monotonic clock, at a cost of two clock reads per stage and frame.
+ *
+ *
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#ifndef LUMA_STATS_H
+#define LUMA_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <chrono>
+
+// Monotonic time in nanoseconds
+inline uint64_t lumaTimeNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class LumaStats
+{
+public:
+    enum stage_t {STAGE_TRANSFORM, STAGE_QUANTIZE, STAGE_CODEC, STAGE_MUX, STAGE_IO, STAGE_NR};
+    static const char *name(stage_t stage);
+    
+    LumaStats() { reset(); }
+    
+    void reset();
+    
+    void addTime(stage_t stage, uint64_t ns)
+    {
+        m_totalNs[stage] += ns;
+        m_frameNs[stage] += ns;
+    }
+    void addPacket(size_t bytes, bool keyframe);
+    void endFrame();
+    void setQueueDepth(const char *queue, unsigned int depth);
+    
+    uint64_t totalNs(stage_t stage) const { return m_totalNs[stage]; }
+    uint64_t lastNs(stage_t stage) const { return m_lastNs[stage]; }
+    uint64_t frames() const { return m_frames; }
+    uint64_t bytes() const { return m_bytes; }
+    uint64_t lastBytes() const { return m_lastBytes; }
+    uint64_t keyframes() const { return m_keyframes; }
+    
+    void print(FILE *out) const;
+    std::string json() const;
+    
+private:
+    struct Queue
+    {
+        std::string name;
+        unsigned int depth, maxDepth;
+        uint64_t sum, samples;
+    };
+    
+    uint64_t m_totalNs[STAGE_NR], m_lastNs[STAGE_NR], m_frameNs[STAGE_NR];
+    uint64_t m_frames, m_bytes, m_lastBytes, m_frameBytes, m_keyframes;
+    std::vector<Queue> m_queues;
+};
+
+// Adds the time from construction to destruction to a stage
+class LumaStageTimer
+{
+public:
+    LumaStageTimer(LumaStats &stats, LumaStats::stage_t stage) :
+        m_stats(stats), m_stage(stage), m_start(lumaTimeNs())
+    {}
+    ~LumaStageTimer() { m_stats.addTime(m_stage, lumaTimeNs() - m_start); }
+    
+private:
+    LumaStats &m_stats;
+    LumaStats::stage_t m_stage;
+    uint64_t m_start;
+};
+
+#endif //LUMA_STATS_H
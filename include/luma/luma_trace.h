@@ -0,0 +1,105 @@
+/**
+ * \class LumaTrace
+ *
+ * \brief Recording of pipeline events in Chrome trace format.
+ *
+ * LumaTrace records begin/end events of the stages in encoding/decoding, for
+ * inspection in chrome://tracing or Perfetto. Each thread appends events to 
+ * its own buffer, without locking, and the buffers are merged and written to
+ * a Chrome Trace JSON file when tracing is stopped or the application exits.
+ * Tracing is enabled with LumaTrace::start(), or by setting the LUMA_TRACE 
+ * environment variable to the output file. When disabled, recording an event
+ * costs a single atomic load.
+ *
+ *
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#ifndef LUMA_TRACE_H
+#define LUMA_TRACE_H
+
+#include <stdint.h>
+#include <string>
+#include <atomic>
+
+class LumaTrace
+{
+public:
+    static bool start(const char *outputFile);
+    static bool startFromEnv();
+    static void stop();
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    
+    // Event names must be string literals, or otherwise outlive the trace
+    static void begin(const char *name, int64_t frame = -1) { if (enabled()) record(name, 'B', frame); }
+    static void end(const char *name) { if (enabled()) record(name, 'E', -1); }
+    
+private:
+    struct Event
+    {
+        const char *name;
+        uint64_t ts;
+        int64_t frame;
+        char phase;
+    };
+    
+    struct Buffer;
+    
+    static void record(const char *name, char phase, int64_t frame);
+    static Buffer *threadBuffer();
+    
+    static std::atomic<bool> s_enabled;
+    static std::atomic<Buffer*> s_buffers;
+    static std::atomic<unsigned int> s_threads;
+    static std::string s_outputFile;
+};
+
+// Records a begin event at construction, and an end event at destruction
+class LumaTraceScope
+{
+public:
+    LumaTraceScope(const char *name, int64_t frame = -1) : m_name(name)
+    {
+        LumaTrace::begin(name, frame);
+    }
+    ~LumaTraceScope() { LumaTrace::end(m_name); }
+    
+private:
+    const char *m_name;
+};
+
+#endif //LUMA_TRACE_H
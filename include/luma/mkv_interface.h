@@ -49,6 +49,7 @@
 #define MKV_INTERFACE_H
 
 #include "ebml/StdIOCallback.h"
+#include "luma_io.h"
 
 #include "ebml/EbmlHead.h"
 #include "ebml/EbmlSubHead.h"
@@ -80,7 +81,14 @@ public:
     ~MkvInterface();
     
     void openWrite(const char *outputFile, const unsigned int w, const unsigned int h, const float maxL, const float minL);
+    void openWrite(IOCallback *output, const unsigned int w, const unsigned int h, const float maxL, const float minL, bool seekable = true);
     void openRead(const char *inputFile);
+    void openRead(IOCallback *input);
+    
+    // Read the meta data of a file, i.e. resolution, duration, number of key
+    // frames and the attachments, without reading any frames and without
+    // printing. Returns false if no video track is found
+    bool probe(const char *inputFile);
     void close();
     void addAttachment(unsigned int uid, const binary* buffer, unsigned int buffer_size, const char* description = "--");
     void addFrame(const uint8 *frame_buffer, unsigned int buffer_size, bool isKey = true);
@@ -90,14 +98,27 @@ public:
     const uint8 *getFrame(unsigned int & buffer_size);
     bool seekToTime(float tm, bool absolute = false);
     
+    // A new cluster is started at each key frame, and before a cluster
+    // exceeds maxBytes or maxDuration (in seconds), which bounds the memory
+    // of buffered frames and the latency of writes. 0 disables a limit
+    void setClusterLimits(size_t maxBytes, float maxDuration);
+    
     void setFramerate(float fps) { m_frameDuration = 1000.0f/fps; }
     void setVerbose(bool verbose) { m_verbose = verbose; }
     int getCurrentTime() { return m_currentTime; }
     int getFrameDuration() { return m_frameDuration; }
     int getDuration() { return m_duration; }
+    unsigned int getWidth() { return m_width; }
+    unsigned int getHeight() { return m_height; }
+    unsigned int getFrames() { return m_frameDuration > 0.0f ? (unsigned int)(m_duration/m_frameDuration + 0.5f) : 0; }
+    unsigned int getKeyFrames() { return m_timeStamps.size(); }
     
 private:
+    void writeHead(const unsigned int w, const unsigned int h, const float maxL, const float minL, const char *outputFile);
+    void readHead(const char *inputName);
     void flushCluster();
+    void abandon();
+    void finishWrite();
     bool findCluster();
     bool findBlockGroup();
     
@@ -108,9 +129,11 @@ private:
     void handleCueData();
     
     bool m_writeMode;
-    bool m_verbose;
+    bool m_verbose, m_quiet;
     
-    StdIOCallback *m_file;
+    // Output/input, which is only deleted on close if opened from a file name
+    IOCallback *m_file;
+    bool m_ownFile, m_seekable;
     KaxTrackEntry *m_track;
     KaxSegment m_fileSegment;
     KaxSeekHead *m_metaSeek;
@@ -120,9 +143,11 @@ private:
     KaxAttached *m_prevAttachment;
     
     KaxCluster *m_cluster;
-    KaxBlockGroup *m_blockGroup, *m_blockGroupPrev;
+    KaxBlockGroup *m_blockGroup, *m_blockGroupPrev, *m_cueBlockGroup;
     
     std::vector<uint8*> m_frameBuffer;
+    size_t m_clusterBytes, m_maxClusterBytes;
+    float m_clusterTimecode, m_maxClusterDuration;
     
     uint64 m_filePosition;
     uint64 m_elementPosition;
@@ -154,6 +179,7 @@ private:
     bool m_allowDummy;
     
     int m_trackNr, m_trackUID, m_currentTime;
+    unsigned int m_width, m_height;
 };
 
 #endif //MKV_INTERFACE_H
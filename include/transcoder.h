@@ -0,0 +1,120 @@
+/**
+ * \class Transcoder
+ *
+ * \brief Re-encoding of a HDR video to one or more renditions, in one pass.
+ *
+ * Transcoder decodes a HDR video once, and encodes each decoded frame to a
+ * number of renditions with different encoding parameters, e.g. a 12 bit
+ * master, a 10 bit PQ version and an 8 bit proxy, without writing the float
+ * frames to disk in between.
+ *
+ * The decoding runs in the calling thread, and each rendition is encoded in
+ * a thread of its own. A decoded frame is moved to a queue of shared frames,
+ * by swapping buffers with the decoder, and is read by all encoders through a
+ * LumaImageView, without being modified or copied. When all encoders are done
+ * with a frame, its buffer is recycled through a LumaFramePool. The length of
+ * the queue limits how far the decoder can run ahead of the slowest encoder.
+ *
+ *
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#ifndef TRANSCODER_H
+#define TRANSCODER_H
+
+#include "luma_decoder.h"
+#include "luma_encoder.h"
+#include "luma_frame_pool.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+struct Rendition
+{
+    Rendition() : frames(0), seconds(0.0), failed(false)
+    {}
+    
+    std::string output;
+    LumaEncoderParams params;
+    
+    // Result of the encoding
+    unsigned int frames;
+    double seconds;
+    bool failed;
+    std::string error;
+};
+
+class Transcoder
+{
+public:
+    Transcoder(unsigned int queueSize = 4);
+    
+    void add(const Rendition &rendition) { m_renditions.push_back(rendition); }
+    
+    // Transcode at most maxFrames frames (0 for all) of an initialized decoder.
+    // Returns false if any of the renditions failed
+    bool run(LumaDecoder &decoder, unsigned int maxFrames = 0, bool verbose = 0);
+    
+    const std::vector<Rendition> &renditions() const { return m_renditions; }
+    unsigned int decodedFrames() const { return m_decoded; }
+    
+private:
+    // Decoded frame, and the number of encoders that have not yet read it
+    struct SharedFrame
+    {
+        LumaFrame frame;
+        unsigned int pending;
+    };
+    
+    void encode(Rendition &rendition);
+    void done(size_t ind);
+    
+    std::vector<Rendition> m_renditions;
+    std::deque<SharedFrame> m_queue;
+    size_t m_first;
+    unsigned int m_queueSize, m_active, m_decoded;
+    bool m_finished;
+    
+    LumaFramePool m_pool;
+    std::mutex m_mutex;
+    std::condition_variable m_frameReady, m_slotAvailable;
+};
+
+#endif //TRANSCODER_H
@@ -0,0 +1,227 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#include <luma_decoder.h>
+#include "luma_metrics.h"
+#include "exr_interface.h"
+#include "luma_exception.h"
+#include "arg_parser.h"
+
+#include <string.h>
+#include <memory>
+
+
+// Determine file extension
+bool hasExtension( const char *file_name, const char *extension )
+{
+    if( file_name == NULL )
+        return false;
+    size_t fn_len = strlen( file_name );
+    size_t ex_len = strlen( extension );
+    
+    if( ex_len >= fn_len )
+        return false;
+    
+    if( strcasecmp( file_name + fn_len - ex_len, extension ) == 0 )
+        return true;
+    
+    return false;
+}
+
+// Quote a string for JSON output, with the escapes of RFC 8259
+std::string jsonString(const std::string &str)
+{
+    std::string res = "\"";
+    for (size_t i=0; i<str.size(); i++)
+    {
+        const unsigned char c = str[i];
+        switch (c)
+        {
+        case '"':  res += "\\\""; break;
+        case '\\': res += "\\\\"; break;
+        case '\b': res += "\\b"; break;
+        case '\f': res += "\\f"; break;
+        case '\n': res += "\\n"; break;
+        case '\r': res += "\\r"; break;
+        case '\t': res += "\\t"; break;
+        default:
+            if (c < 0x20)
+            {
+                char hex[8];
+                snprintf(hex, 8, "\\u%04x", c);
+                res += hex;
+            }
+            else
+                res += c;
+        }
+    }
+    return res + "\"";
+}
+
+// Input/output specific information
+struct IOData
+{
+    IOData() : startFrame(1), frames(0), threads(0), quiet(0)
+    {}
+    
+    std::string inputFile, referenceFile, outputFile;
+    unsigned int startFrame, frames, threads;
+    bool quiet;
+};
+
+// Parse parameter options from command line
+bool setParams(int argc, char* argv[], IOData *io)
+{
+    // Application usage info
+    std::string info = std::string("lumacompare -- Measure the quality of a HDR video that has been encoded with the HDRv codec\n\n") +
+                       std::string("Usage: lumacompare --input <hdr_video> --reference <hdr_frames|hdr_video>\n");
+    std::string postInfo = std::string("\nExample: lumacompare -i hdr_video.mkv -r hdr_frame_%05d.exr -o quality.json\n\n") +
+                           std::string("See man page for more information.");
+    ArgParser argHolder(info, postInfo);
+    
+    // Input arguments
+    argHolder.add(&io->inputFile,     "--input",       "-i",  "Input HDR video", 0);
+    argHolder.add(&io->referenceFile, "--reference",   "-r",  "Reference HDR frames (EXR), or HDR video", 0);
+    argHolder.add(&io->startFrame,    "--start-frame", "-s",  "Number of the first reference EXR frame");
+    argHolder.add(&io->frames,        "--frames",      "-f",  "Number of frames to compare. 0 for all frames");
+    argHolder.add(&io->threads,       "--threads",     "-t",  "Number of threads for the metrics. 0 for one per core", (unsigned int)(0), (unsigned int)(256));
+    argHolder.add(&io->outputFile,    "--output",      "-o",  "Write the results of each frame, and the mean, to a JSON file");
+    argHolder.add(&io->quiet,         "--quiet",       "-q",  "Only display the mean over all frames");
+    
+    // Parse arguments
+    if (!argHolder.read(argc, argv))
+        return 0;
+    
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    // Holder for input/output options
+    IOData io;
+    
+    try
+    {
+        if (!setParams(argc, argv, &io))
+            return 1;
+        
+        // Decoder of the tested video, and of a reference video
+        LumaDecoder decoder(io.inputFile.c_str());
+        std::unique_ptr<LumaDecoder> refDecoder;
+        if (hasExtension(io.referenceFile.c_str(), ".mkv"))
+            refDecoder.reset(new LumaDecoder(io.referenceFile.c_str()));
+        
+        LumaMetrics metrics(io.threads);
+        LumaFrame refFrame, *frame, *ref;
+        std::string json;
+
+#define STRBUF_LEN 500
+        char str[STRBUF_LEN];
+        if (!io.quiet)
+            printf("%-8s %10s %10s %10s %12s\n", "frame", "PU-PSNR", "log-PSNR", "PU-SSIM", "dE-ITP");
+        for (unsigned int f=0; !io.frames || f < io.frames; f++)
+        {
+            // Decoded frame. The decoder owns the frame, until the next call to decode()
+            frame = decoder.decode();
+            if (frame == NULL)
+                break;
+            
+            // Reference frame
+            if (refDecoder)
+            {
+                if ((ref = refDecoder->decode()) == NULL)
+                    break;
+            }
+            else
+            {
+                snprintf(str, STRBUF_LEN-1, io.referenceFile.c_str(), io.startFrame + f);
+                ExrInterface::readFrame(str, refFrame);
+                ref = &refFrame;
+            }
+            
+            LumaMetricsResult res = metrics.compare(*ref, *frame);
+            if (!io.quiet)
+            {
+                printf("%-8u %10.3f %10.3f %10.5f %12.4f\n", f+1, res.puPsnr, res.logPsnr, res.puSsim, res.deltaEitp);
+                fflush(stdout);
+            }
+            
+            if (io.outputFile.size() > 0)
+            {
+                snprintf(str, STRBUF_LEN-1, "%s\n    {\"frame\": %u, \"metrics\": ", f ? "," : "", f+1);
+                json += str + metrics.json(res) + "}";
+            }
+        }
+        
+        if (!metrics.frames())
+            throw LumaException("No frames to compare");
+        
+        LumaMetricsResult mean = metrics.mean();
+        if (!io.quiet)
+            printf("\n");
+        printf("%-8s %10.3f %10.3f %10.5f %12.4f\n", "mean", mean.puPsnr, mean.logPsnr, mean.puSsim, mean.deltaEitp);
+        fprintf(stderr, "\nComparison finished. %u frames compared.\n", metrics.frames());
+        
+        if (io.outputFile.size() > 0)
+        {
+            FILE *fp = fopen(io.outputFile.c_str(), "w");
+            if (fp == NULL)
+                throw LumaException("Unable to open output file for writing");
+            fprintf(fp, "{\n  \"input\": %s,\n  \"reference\": %s,\n  \"frames\": [%s\n  ],\n  \"mean\": %s\n}\n",
+                    jsonString(io.inputFile).c_str(), jsonString(io.referenceFile).c_str(), json.c_str(), metrics.json(mean).c_str());
+            fclose(fp);
+        }
+    }
+    catch (ParserException &e)
+    {
+        fprintf(stderr, "\nlumacompare input error: %s\n", e.what());
+        return 1;
+    }
+    catch (LumaException &e)
+    {
+        fprintf(stderr, "\nlumacompare error: %s\n", e.what());
+        return 1;
+    }
+    catch (std::exception & e)
+    {
+        fprintf(stderr, "\nlumacompare error: %s\n", e.what());
+        return 1;
+    }
+    
+    return 0;
+}
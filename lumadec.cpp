@@ -38,6 +38,9 @@
 
 #include <luma_decoder.h>
 #include "exr_interface.h"
+#include "luma_alloc.h"
+#include "luma_trace.h"
+#include "exr_writer.h"
 #include "pfs_interface.h"
 #include "luma_exception.h"
 #include "arg_parser.h"
@@ -65,9 +68,26 @@ bool hasExtension( const char *file_name, const char *extension )
     return false;
 }
 
+// Output specific information
+struct IOData
+{
+    IOData() : writeThreads(4), exrFloat(0), verbose(0), stats(0), compression(ExrInterface::EXR_ZIP)
+    {}
+    
+    std::string hdrFrames, inputFile, statsFile, traceFile;
+    unsigned int writeThreads;
+    bool exrFloat, verbose, stats;
+    ExrInterface::compression_t compression;
+    LumaAllocPolicy allocPolicy;
+};
+
 // Parse parameter options from command line
-bool setParams(int argc, char* argv[], std::string &hdrFrames, std::string &inputFile, bool &verbose)
+bool setParams(int argc, char* argv[], IOData *io)
 {
+    std::string comp, compValues[] = {"NONE", "ZIP", "PIZ", "DWAA"}; // valid EXR compression values
+    std::string hp, hpValues[] = {"OFF", "THP", "HUGETLB"}; // valid huge page input values
+    bool firstTouch = false;
+    
     // Application usage info
     std::string info = std::string("lumadec -- Decode a high dynamic range (HDR) video that has been encoded with the HDRv codec\n\n") +
                        std::string("Usage: lumadec --input <hdr_video> --output <hdr_frames>\n");
@@ -76,21 +96,45 @@ bool setParams(int argc, char* argv[], std::string &hdrFrames, std::string &inpu
     ArgParser argHolder(info, postInfo);
     
     // Input arguments
-    argHolder.add(&inputFile, "--input",   "-i", "Input HDR video", 0);
-    argHolder.add(&hdrFrames, "--output",  "-o", "Output location of decoded HDR frames");
-    argHolder.add(&verbose,   "--verbose", "-v", "Verbose mode");
+    argHolder.add(&io->inputFile,    "--input",           "-i",  "Input HDR video", 0);
+    argHolder.add(&io->hdrFrames,    "--output",          "-o",  "Output location of decoded HDR frames");
+    argHolder.add(&comp,             "--exr-compression", "-ec", "Compression of EXR output frames", compValues, 4);
+    argHolder.add(&io->exrFloat,     "--exr-float",       "-ef", "Store EXR output frames with 32 bit float channels");
+    argHolder.add(&io->writeThreads, "--write-threads",   "-wt", "Number of threads for writing EXR frames. 0 for writing in the decoding thread", (unsigned int)(0), (unsigned int)(64));
+    argHolder.add(&hp,               "--huge-pages",      "-hp", "Huge pages for frame buffers (off, transparent or explicit huge pages)", hpValues, 3);
+    argHolder.add(&firstTouch,       "--first-touch",     "-ft", "Fault in frame buffers when they are allocated");
+    argHolder.add(&io->stats,        "--stats",           "-st", "Display timings and counters of the decoding stages");
+    argHolder.add(&io->statsFile,    "--stats-json",      "-sj", "Write timings and counters of the decoding stages to a JSON file");
+    argHolder.add(&io->traceFile,    "--trace",           "-tr", "Write a Chrome trace of the decoding stages to a JSON file");
+    argHolder.add(&io->verbose,      "--verbose",         "-v",  "Verbose mode");
     
     // Parse arguments
     if (!argHolder.read(argc, argv))
         return 0;
+    
+    // Translate input strings to enums
+    if (!strcmp(comp.c_str(), compValues[0].c_str()))
+        io->compression = ExrInterface::EXR_NONE;
+    else if (!strcmp(comp.c_str(), compValues[1].c_str()))
+        io->compression = ExrInterface::EXR_ZIP;
+    else if (!strcmp(comp.c_str(), compValues[2].c_str()))
+        io->compression = ExrInterface::EXR_PIZ;
+    else if (!strcmp(comp.c_str(), compValues[3].c_str()))
+        io->compression = ExrInterface::EXR_DWAA;
+
+    if (!strcmp(hp.c_str(), hpValues[1].c_str()))
+        io->allocPolicy.pages = LumaAllocPolicy::PAGES_HUGE;
+    else if (!strcmp(hp.c_str(), hpValues[2].c_str()))
+        io->allocPolicy.pages = LumaAllocPolicy::PAGES_HUGETLB;
+    io->allocPolicy.firstTouch = firstTouch;
 
     return 1;
 }
 
 int main(int argc, char* argv[])
 {
-    std::string hdrFrames, inputFile;
-    bool verbose = 0;
+    // Holder for input/output options
+    IOData io;
     
 #ifdef HAVE_PFS
     PfsInterface pfs; // Needs to store state between frames
@@ -98,11 +142,23 @@ int main(int argc, char* argv[])
     
     try
     {
-        if (!setParams(argc, argv, hdrFrames, inputFile, verbose))
+        if (!setParams(argc, argv, &io))
             return 1;
         
+        // Allocation of frame buffers
+        LumaAllocPolicy::setDefault(io.allocPolicy);
+        
+        // Event tracing, from command line or the LUMA_TRACE environment variable
+        if (!LumaTrace::start(io.traceFile.c_str()))
+            LumaTrace::startFromEnv();
+        
         // Decoder
-        LumaDecoder decoder(inputFile.c_str(), verbose);
+        LumaDecoder decoder(io.inputFile.c_str(), io.verbose);
+        
+        // Writing of EXR frames, in parallel with decoding
+        ExrWriter writer(io.writeThreads, 2*io.writeThreads);
+        writer.setCompression(io.compression);
+        writer.setHalf(!io.exrFloat);
         
         // Frame for retrieving and storing decoded frames
         LumaFrame *frame;
@@ -125,25 +181,47 @@ int main(int argc, char* argv[])
             decoded_frame_count++;
             
             // Write hdr frames
-            if( hdrFrames.size() == 0 || hasExtension( hdrFrames.c_str(), "pfs" ) )
+            uint64_t writeStart = lumaTimeNs();
             {
+                LumaTraceScope trace("put_output", f);
+                if( io.hdrFrames.size() == 0 || hasExtension( io.hdrFrames.c_str(), "pfs" ) )
+                {
 #ifdef HAVE_PFS
-                if( !pfs.writeFrame(hdrFrames.c_str(), *frame) )
-                    break;
+                    if( !pfs.writeFrame(io.hdrFrames.c_str(), *frame) )
+                        break;
 #else
-                throw LumaException( "Compiled without pfstools support" );          
+                    throw LumaException( "Compiled without pfstools support" );          
 #endif
+                }
+                else
+                {
+                    snprintf(str, STRBUF_LEN-1, io.hdrFrames.c_str(), f);
+                    //sprintf(str, hdrFrames.size() == 0 ? "output_%05d.exr" : hdrFrames.c_str(), f);
+                    writer.writeFrame(str, *frame);
+                    decoder.getStats().setQueueDepth("write", writer.queueDepth());
+                }
             }
-            else
-            {
-                snprintf(str, STRBUF_LEN-1, hdrFrames.c_str(), f);
-                //sprintf(str, hdrFrames.size() == 0 ? "output_%05d.exr" : hdrFrames.c_str(), f);
-                if (!ExrInterface::writeFrame(str, *frame))
-                    break;
-            }
+            decoder.getStats().addTime(LumaStats::STAGE_IO, lumaTimeNs() - writeStart);
         }
         
+        // Waiting for the remaining writes
+        uint64_t finishStart = lumaTimeNs();
+        writer.finish();
+        decoder.getStats().addTime(LumaStats::STAGE_IO, lumaTimeNs() - finishStart);
+        
         fprintf(stderr, "\n\nDecoding finished. %d frames decoded.\n", decoded_frame_count);
+
+        // Report statistics
+        if (io.stats)
+            decoder.getStats().print(stderr);
+        if (io.statsFile.size() > 0)
+        {
+            FILE *fp = fopen(io.statsFile.c_str(), "w");
+            if (fp == NULL)
+                throw LumaException("Unable to open statistics file for writing");
+            fputs(decoder.getStats().json().c_str(), fp);
+            fclose(fp);
+        }
     }
     catch (ParserException &e)
     {
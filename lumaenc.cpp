@@ -38,24 +38,34 @@
 
 #include <luma_encoder.h>
 #include "exr_interface.h"
+#include "luma_alloc.h"
+#include "luma_trace.h"
+#include "exr_reader.h"
+#include "batch_encoder.h"
 #include "pfs_interface.h"
 #include "luma_exception.h"
 #include "arg_parser.h"
 
 #include <iostream>
+#include <fstream>
 #include <string.h>
+#include <memory>
+#include <vector>
 
 #include "config.h"
 
 // Input and output specific information
 struct IOData
 {
-    IOData() : startFrame(1), endFrame(9999), stepFrame(1), verbose(0)
+    IOData() : startFrame(1), endFrame(9999), stepFrame(1), exrThreads(4), 
+               readThreads(2), prefetch(4), batchWorkers(0), codecThreads(0), verbose(0), stats(0)
     {}
     
-    std::string hdrFrames, outputFile;
-    unsigned int startFrame, endFrame, stepFrame;
-    bool verbose;
+    std::string hdrFrames, outputFile, statsFile, traceFile, batchFile;
+    unsigned int startFrame, endFrame, stepFrame, exrThreads, readThreads, prefetch;
+    unsigned int batchWorkers, codecThreads;
+    bool verbose, stats;
+    LumaAllocPolicy allocPolicy;
 };
 
 // Determine file extension
@@ -111,19 +121,22 @@ bool setParams(int argc, char* argv[], LumaEncoderParams *params, IOData *io)
     std::string ptf, ptfValues[] = {"PSI", "PQ", "LOG", "HDRVDP", "LINEAR"}; // valid ptf input values
     std::string cs, csValues[] = {"LUV", "RGB", "YCBCR", "XYZ"}; // valid color space input values
     unsigned int bdValues[] = {8, 10, 12}; // valid bit depths
+    std::string hp, hpValues[] = {"OFF", "THP", "HUGETLB"}; // valid huge page input values
+    bool firstTouch = false;
 
     // Application usage info
     std::string info = std::string("lumaenc -- Compress a sequence of high dyncamic range (HDR) frames in to a Matroska (.mkv) HDR video\n\n") +
                        std::string("Usage: lumaenc --input <hdr_frames> \\\n") +
                        std::string("               --frames <start_frame:step:end_frame> \\\n") +
-                       std::string("               --output <output>\n");
+                       std::string("               --output <output>\n") +
+                       std::string("       lumaenc --batch <job_list>\n");
     std::string postInfo = std::string("\nExample: lumaenc -i hdr_frame_%05d.exr -f 1:100 -o hdr_video.mkv\n\n") +
                            std::string("See man page for more information.");
     ArgParser argHolder(info, postInfo);
 
     // Input arguments
     argHolder.add(&io->hdrFrames,            "--input",             "-i",   "Input HDR video sequence");
-    argHolder.add(&io->outputFile,           "--output",            "-o",   "Output location of the compressed HDR video", 0);
+    argHolder.add(&io->outputFile,           "--output",            "-o",   "Output location of the compressed HDR video");
     argHolder.add(&frames,                   "--frames",            "-f",   "Input frames, formatted as startframe:step:endframe");
     argHolder.add(&params->fps,              "--framerate",         "-fps", "Framerate of video stream, specified as frames/s");
     argHolder.add(&params->profile,          "--profile",           "-p",   "VP9 encoding profile", (unsigned int)(0), (unsigned int)(3));
@@ -137,16 +150,33 @@ bool setParams(int argc, char* argv[], LumaEncoderParams *params, IOData *io)
     argHolder.add(&params->minLum,           "--min-luminance",     "-mi",  "Minimum luminance in encoding (for PQ and LOG transfer function)", 1e-10f, 99.99f);
     argHolder.add(&params->bitrate,          "--bitrate",           "-b",   "HDR video stream target bandwidth, in Kb/s", (unsigned int)(0), (unsigned int)(9999));
     argHolder.add(&params->keyframeInterval, "--keyframe-interval", "-k",   "Interval between keyframes. 0 for automatic keyframes", (unsigned int)(0), (unsigned int)(9999));
+    argHolder.add(&params->maxKeyframeInterval, "--max-keyframe-interval", "-mk", "Maximum interval between automatic keyframes", (unsigned int)(1), (unsigned int)(9999));
+    argHolder.add(&params->sceneCutThreshold, "--scene-cut", "-cut", "Threshold of scene cut detection for automatic keyframes, 0-1. 0 disables the detection", 0.0f, 1.0f);
+    argHolder.add(&params->maxClusterSize,   "--max-cluster-size",  "-mcs", "Maximum size of a Matroska cluster, in KB. 0 for no limit", (unsigned int)(0), (unsigned int)(1048576));
+    argHolder.add(&params->maxClusterDuration, "--max-cluster-duration", "-mcd", "Maximum duration of a Matroska cluster, in s. 0 for no limit", 0.0f, 32.0f);
     argHolder.add(&params->bitDepth,         "--encoding-bitdepth", "-eb",  "Encoding at 8, 10 or 12 bits", bdValues, 3);
     argHolder.add(&params->lossLess,         "--lossless",          "-l",   "Enable lossless encoding mode");
+    argHolder.add(&io->codecThreads,         "--codec-threads",     "-ct",  "Number of VP9 encoder threads. 0 for the default", (unsigned int)(0), (unsigned int)(64));
+    argHolder.add(&io->batchFile,            "--batch",             "-bt",  "Encode the jobs in a list, with the options of one job per line");
+    argHolder.add(&io->batchWorkers,         "--batch-workers",     "-bw",  "Number of jobs encoded concurrently in batch mode. 0 for half the cores", (unsigned int)(0), (unsigned int)(256));
+    argHolder.add(&io->exrThreads,           "--exr-threads",       "-et",  "Number of threads for decompression of EXR input frames", (unsigned int)(0), (unsigned int)(64));
+    argHolder.add(&io->readThreads,          "--read-threads",      "-rt",  "Number of threads for reading EXR input frames in the background", (unsigned int)(1), (unsigned int)(64));
+    argHolder.add(&io->prefetch,             "--prefetch",          "-pf",  "Number of EXR input frames to read ahead. 0 for no prefetching", (unsigned int)(0), (unsigned int)(256));
+    argHolder.add(&hp,                       "--huge-pages",        "-hp",  "Huge pages for frame buffers (off, transparent or explicit huge pages)", hpValues, 3);
+    argHolder.add(&firstTouch,               "--first-touch",       "-ft",  "Fault in frame buffers when they are allocated");
+    argHolder.add(&io->stats,                "--stats",             "-st",  "Display timings and counters of the encoding stages");
+    argHolder.add(&io->statsFile,            "--stats-json",        "-sj",  "Write timings and counters of the encoding stages to a JSON file");
+    argHolder.add(&io->traceFile,            "--trace",             "-tr",  "Write a Chrome trace of the encoding stages to a JSON file");
     argHolder.add(&io->verbose,              "--verbose",           "-v",   "Verbose mode");
 
     // Parse arguments
     if (!argHolder.read(argc, argv))
         return 0;
     
-    // Check output format
-    if (!hasExtension(io->outputFile.c_str(), ".mkv"))
+    // Check output format. The outputs of batch jobs are given in the job list
+    if (io->batchFile.size() == 0 && io->outputFile.size() == 0)
+        throw ParserException("Missing required option '--output'");
+    if (io->batchFile.size() == 0 && !hasExtension(io->outputFile.c_str(), ".mkv"))
         throw ParserException("Unsupported output format. HDR video should be stored as Matroska file (.mkv)");
     
     // Parse frame range
@@ -178,9 +208,129 @@ bool setParams(int argc, char* argv[], LumaEncoderParams *params, IOData *io)
     else if (!strcmp(cs.c_str(), csValues[3].c_str()))
         params->colorSpace = LumaQuantizer::CS_XYZ;
 
+    if (!strcmp(hp.c_str(), hpValues[1].c_str()))
+        io->allocPolicy.pages = LumaAllocPolicy::PAGES_HUGE;
+    else if (!strcmp(hp.c_str(), hpValues[2].c_str()))
+        io->allocPolicy.pages = LumaAllocPolicy::PAGES_HUGETLB;
+    io->allocPolicy.firstTouch = firstTouch;
+
     return 1;
 }
 
+// Read a batch job list. Each line holds the options of one job, which are
+// added to the options from the command line. Empty lines, and lines starting
+// with '#', are skipped. Options that apply to the whole process can only be
+// given on the command line
+void readJobs(const IOData &io, const LumaEncoderParams &params, BatchEncoder &batch)
+{
+    const char *globalOptions[] = {"--batch", "-bt", "--batch-workers", "-bw", "--exr-threads", "-et",
+                                   "--read-threads", "-rt", "--prefetch", "-pf", "--huge-pages", "-hp",
+                                   "--first-touch", "-ft", "--stats", "-st", "--stats-json", "-sj",
+                                   "--trace", "-tr"};
+    
+    std::ifstream file(io.batchFile.c_str());
+    if (!file)
+        throw LumaException("Unable to open batch job list");
+    
+    std::string line;
+    unsigned int lineNr = 0;
+    while (std::getline(file, line))
+    {
+        lineNr++;
+        
+        // Split into arguments, with double quotes around arguments with spaces
+        std::vector<std::string> args(1, "lumaenc");
+        bool quoted = false, arg = false;
+        for (size_t i=0; i<line.size(); i++)
+        {
+            if (line[i] == '"')
+            {
+                quoted = !quoted;
+                if (!arg)
+                    args.push_back("");
+                arg = true;
+            }
+            else if (!quoted && isspace((unsigned char)line[i]))
+                arg = false;
+            else
+            {
+                if (!arg)
+                    args.push_back("");
+                args.back() += line[i];
+                arg = true;
+            }
+        }
+        
+        if (args.size() < 2 || args[1][0] == '#')
+            continue;
+        
+        std::vector<char*> argv;
+        for (size_t i=0; i<args.size(); i++)
+            argv.push_back(&args[i][0]);
+        
+        IOData jobIO = io;
+        jobIO.batchFile.clear();
+        jobIO.outputFile.clear();
+        LumaEncoderParams jobParams = params;
+        char str[50];
+        snprintf(str, 49, "line %u: ", lineNr);
+        try
+        {
+            for (size_t i=1; i<args.size(); i++)
+                for (size_t j=0; j<sizeof(globalOptions)/sizeof(globalOptions[0]); j++)
+                    if (args[i] == globalOptions[j])
+                        throw ParserException(("Option '" + args[i] + "' can only be given on the command line, not for a batch job").c_str());
+            
+            if (!setParams((int)argv.size(), &argv[0], &jobParams, &jobIO))
+                throw ParserException("Help is not available for batch jobs");
+            if (jobIO.hdrFrames.size() == 0 || hasExtension(jobIO.hdrFrames.c_str(), "pfs"))
+                throw ParserException("Batch jobs need OpenEXR input frames");
+        }
+        catch (ParserException &e)
+        {
+            std::string msg = io.batchFile + ", " + str + e.what();
+            throw ParserException(msg);
+        }
+        
+        BatchJob job;
+        job.input = jobIO.hdrFrames;
+        job.output = jobIO.outputFile;
+        job.startFrame = jobIO.startFrame;
+        job.stepFrame = jobIO.stepFrame;
+        job.endFrame = jobIO.endFrame;
+        job.params = jobParams;
+        job.params.threads = jobIO.codecThreads;
+        batch.add(job);
+    }
+}
+
+// Encode a list of jobs concurrently
+int runBatch(const IOData &io, const LumaEncoderParams &params)
+{
+    BatchEncoder batch(io.batchWorkers, io.codecThreads);
+    readJobs(io, params, batch);
+    
+    fprintf(stderr, "Batch encoding of %lu jobs, with %u workers and %u codec threads per worker\n\n",
+            (unsigned long)batch.jobs().size(), batch.workers(), batch.codecThreads());
+    
+    uint64_t start = lumaTimeNs();
+    bool res = batch.run();
+    double seconds = (lumaTimeNs() - start) * 1e-9;
+    
+    unsigned int frames = 0, failed = 0;
+    for (size_t i=0; i<batch.jobs().size(); i++)
+    {
+        frames += batch.jobs()[i].frames;
+        failed += batch.jobs()[i].failed;
+    }
+    
+    fprintf(stderr, "\n\nBatch encoding finished. %lu of %lu jobs encoded, %u frames in %.2f s (%.1f fps).\n",
+            (unsigned long)(batch.jobs().size() - failed), (unsigned long)batch.jobs().size(),
+            frames, seconds, seconds > 0.0 ? frames / seconds : 0.0);
+    
+    return res ? 0 : 1;
+}
+
 int main(int argc, char* argv[])
 {
     // Holder for input/output options
@@ -201,32 +351,66 @@ int main(int argc, char* argv[])
             return 1;
         
         // Set the encoder parameters    
+        if (io.codecThreads > 0)
+            params.threads = io.codecThreads;
         encoder.setParams(params);
+        
+        // Allocation of frame and codec buffers
+        LumaAllocPolicy::setDefault(io.allocPolicy);
+        
+        // Event tracing, from command line or the LUMA_TRACE environment variable
+        if (!LumaTrace::start(io.traceFile.c_str()))
+            LumaTrace::startFromEnv();
+        
+        ExrInterface::setThreadCount(io.exrThreads);
+        
+        if (io.batchFile.size() > 0)
+            return runBatch(io, params);
+        
+        // Read EXR frames ahead of the encoder
+        std::unique_ptr<ExrReader> reader;
+        if (io.prefetch > 0 && io.hdrFrames.size() > 0 && !hasExtension(io.hdrFrames.c_str(), "pfs")
+            && strcmp(io.hdrFrames.c_str(), "__test__") != 0)
+            reader.reset(new ExrReader(io.hdrFrames.c_str(), io.startFrame, io.stepFrame, io.endFrame,
+                                       io.readThreads, io.prefetch));
 
 #define STRBUF_LEN 500
         char str[STRBUF_LEN];
         int encoded_frame_count = 0;    
+        float readTime = -1.0f;
+        LumaFrame frame; // Buffers are recycled between frames
         for (unsigned int f = io.startFrame; f <= io.endFrame; f+=io.stepFrame)
         {        
-            LumaFrame frame;
-
-            // Read hdr frames, if available
-            if( io.hdrFrames.size() == 0 || hasExtension( io.hdrFrames.c_str(), "pfs" ) )
+            uint64_t readStart = lumaTimeNs();
             {
+                LumaTraceScope trace("get_input", f);
+
+                // Read hdr frames, if available
+                if( io.hdrFrames.size() == 0 || hasExtension( io.hdrFrames.c_str(), "pfs" ) )
+                {
 #ifdef HAVE_PFS
-                if( !pfs.readFrame(io.hdrFrames.c_str(), frame) )
-                    break;
+                    if( !pfs.readFrame(io.hdrFrames.c_str(), frame) )
+                        break;
 #else
-                throw LumaException( "Compiled without pfstools support" );          
+                    throw LumaException( "Compiled without pfstools support" );          
 #endif
+                }
+                else if ( strcmp( io.hdrFrames.c_str(), "__test__" ) == 0 )
+                    ExrInterface::testFrame(frame);
+                else if (reader)
+                {
+                    if (!reader->readFrame(frame, &readTime))
+                        break;
+                }
+                else // OpenEXR?          
+                {
+                    snprintf(str, STRBUF_LEN-1, io.hdrFrames.c_str(), f);
+                    ExrInterface::readFrame(str, frame, &readTime);
+                }
             }
-            else if ( strcmp( io.hdrFrames.c_str(), "__test__" ) == 0 )
-                ExrInterface::testFrame(frame);
-            else // OpenEXR?          
-            {
-                snprintf(str, STRBUF_LEN-1, io.hdrFrames.c_str(), f);
-                ExrInterface::readFrame(str, frame);
-            }
+            encoder.getStats().addTime(LumaStats::STAGE_IO, lumaTimeNs() - readStart);
+            if (reader)
+                encoder.getStats().setQueueDepth("prefetch", reader->queueDepth());
 
             // Initialize encoder
             if (!encoder.initialized())
@@ -237,12 +421,27 @@ int main(int argc, char* argv[])
             // Run the encoder
             encoder.encode(&frame);
             encoded_frame_count++;
-            fprintf(stderr, "done\n");
+            if (io.verbose && readTime >= 0.0f)
+                fprintf(stderr, "done (EXR read: %.2f ms)\n", readTime);
+            else
+                fprintf(stderr, "done\n");
         }
 
         encoder.finish();
         fprintf(stderr, "\n\nEncoding finished. %d frames encoded.\n", encoded_frame_count);
 
+        // Report statistics
+        if (io.stats)
+            encoder.getStats().print(stderr);
+        if (io.statsFile.size() > 0)
+        {
+            FILE *fp = fopen(io.statsFile.c_str(), "w");
+            if (fp == NULL)
+                throw LumaException("Unable to open statistics file for writing");
+            fputs(encoder.getStats().json().c_str(), fp);
+            fclose(fp);
+        }
+
     }
     catch (ParserException &e)
     {
@@ -38,8 +38,15 @@
 
 #include <cstdio>
 #include <math.h>
+#include <string.h>
 #include <fstream>
 #include <iostream>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 #include <GL/glew.h>
 
@@ -50,11 +57,21 @@
 #endif
 
 #include <luma_decoder.h>
+#include <luma_trace.h>
 #include "luma_exception.h"
 #include "arg_parser.h"
 
 #include "config.h"
 
+#ifdef HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#ifdef HAVE_OPENEXR
+#include "exr_interface.h"
+#endif
+
 
 
 // === Necessary globals =======================================================
@@ -80,17 +97,17 @@ const unsigned char gui_texture[] = {
 // Need to be defined globally, since variables cannot be passed to GLUT callbacks
 struct GlutState
 {
-    GlutState() : pausePlayback(0), doTmo(0), seek(0), showTimings(0), ldrSim(0),
+    GlutState() : pausePlayback(0), doTmo(0), showTimings(0), ldrSim(0),
         mousePressL1(0), mousePressL2(0), fullScreen(0), firstClick(0),
-        dispTimeTot(0.0f), totTimeTot(0.0f), exposure(1.0f), fps(-1.0f), 
+        exposure(1.0f), fps(-1.0f), 
         frameDuration(40.0f), inactiveTime(-1e10f), guiTime(2000.0f), 
         frameNr(0), guiButton(0)
     {}
     
-    bool hbd, pausePlayback, doTmo, seek, showTimings, ldrSim, mousePressL1, 
+    bool hbd, pausePlayback, doTmo, showTimings, ldrSim, mousePressL1, 
          mousePressL2, fullScreen, firstClick;
          
-    float dispTimeTot, totTimeTot, exposure, fps, frameDuration,
+    float exposure, fps, frameDuration,
           duration, inactiveTime, guiTime;
           
     unsigned int windNr, stride[3], frameNr, guiButton,
@@ -98,14 +115,75 @@ struct GlutState
                  heightWin, widthWin0, heightWin0,
                  sx, sy, x0, y0, sxGUI, syGUI, x0GUI, y0GUI,
                  Sx0, Sx1, Sx2, Sx3, Sy0, Sy1;
-                 
-    timeval start1, start2, stop;
     
     LumaDecoder decoder;
     
     GLfloat strideRatio;
     GLuint dequantProg, guiProg, texC1, texC2, texC3, texGUI1, texGUI2, texM;
 } state;
+
+// Ring of pixel buffer objects (PBOs), that the decoded frames are streamed
+// through to the textures. While a frame is uploaded from one PBO, the next
+// frame can be written to another one. The PBOs are persistently mapped if
+// ARB_buffer_storage is supported, and are otherwise mapped for each frame
+struct UploadRing
+{
+    UploadRing() : frameBytes(0), persistent(0), next(0)
+    {}
+    
+    static const unsigned int size = 4;
+    
+    GLuint pbo[size];
+    unsigned char *mapped[size];
+    GLsync fence[size];
+    size_t offset[3], frameBytes;
+    bool persistent;
+    unsigned int next;
+} upload;
+
+// Decoded frame in a PBO of the ring, waiting to be presented
+struct DecodedFrame
+{
+    unsigned int slot, frameNr, generation;
+    float duration, decodeTime;
+};
+
+// Playback is split between a decoder thread, that decodes frames to free
+// PBOs, and the GLUT thread, that uploads and presents the decoded frames at
+// their presentation time, driven by a timer. The GLUT thread is the only one
+// making GL calls; it maps the PBOs and hands them to the decoder thread.
+// Seeking bumps the generation, so that frames decoded before the seek are
+// discarded
+struct Playback
+{
+    Playback() : generation(0), seekTime(-1.0f), stop(false), end(false), loop(true), clockValid(false),
+        showNext(true), clockStart(0.0), lastPresent(-1.0), clockFrameNr(0), presented(0), intervals(0), dropped(0),
+        sum(0.0), sumSq(0.0), minTime(1e10), maxTime(0.0), decodeSum(0.0), reportTime(0.0)
+    {}
+    
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable slotFree, frameReady;
+    
+    // Shared between the threads
+    std::deque<unsigned int> free;
+    std::deque<DecodedFrame> ready;
+    unsigned int generation;
+    float seekTime;
+    bool stop, end, loop;
+    std::string error;
+    
+    // GLUT thread only. Slots with uploads in flight, and the presentation
+    // clock, as the time of frame 1 in ms, and the last frame it was used for
+    std::deque<unsigned int> uploading;
+    bool clockValid, showNext;
+    double clockStart, lastPresent;
+    unsigned int clockFrameNr;
+    
+    // Frame time statistics, reported with 'z'
+    unsigned int presented, intervals, dropped;
+    double sum, sumSq, minTime, maxTime, decodeSum, reportTime;
+} playback;
 }
 
 // =============================================================================
@@ -114,6 +192,7 @@ struct GlutState
 
 // === Setup and initialization ================================================
 int loadTexture(GLuint t);
+void setupFrameTextures();
 bool setupShader(GLuint &shader, GLuint &program, const GLchar** shader_src);
 void setupGUI();
 void init(float gammaVal, float userScaling);
@@ -122,16 +201,35 @@ void init(float gammaVal, float userScaling);
 
 
 // === Utility functions for use during playback ===============================
-bool getFrame();
+double timeMs();
+bool getFrame(global::DecodedFrame &frame);
+void decodeFrames();
+void stopDecoding();
+void requestFrames(bool wait = false);
+bool mapUploadSlot(unsigned int slot, bool wait);
+void fillUploadSlot(unsigned char *dest);
+void uploadFrame(unsigned int slot);
 void resetGuiTime();
+void togglePause();
 void seekToTime(float time);
 bool positionSlider(unsigned int x);
 // =============================================================================
 
 
 
+// === Offscreen rendering =====================================================
+void createHeadlessContext();
+void renderHeadless(const std::string &outputFile, unsigned int maxFrames, bool linear,
+                    float gammaVal, float userScaling);
+bool writePng(const char *file, const unsigned char *rgb, unsigned int w, unsigned int h);
+// =============================================================================
+
+
+
 // === Callback functions ======================================================
+void drawFrame();
 void display();
+void present(int);
 void reshape(int w, int h);
 void doubleClickRegistration(int);
 void mouse(int button, int state, int xi, int yi);
@@ -146,8 +244,10 @@ void keyboard(unsigned char key, int x, int);
 
 int main(int argc, char** argv)
 {
-    std::string inputFile;
+    std::string inputFile, traceFile, outputFile;
     float gammaVal = 2.2f, userScaling = 1.0f;
+    bool headless = false, linear = false;
+    unsigned int maxFrames = 0;
 
     // Application usage info
     std::string info = 
@@ -162,9 +262,10 @@ int main(int argc, char** argv)
         std::string("  -/=\t\t\tDecrease exposure\n") +
         std::string("  t\t\t\tApply simple sigmoid tone curve\n") +
         std::string("  l\t\t\tSimulate low dynamic range (LDR) video\n") +
-        std::string("  z\t\t\tShow timings\n");
+        std::string("  z\t\t\tShow frame time statistics, once per second\n");
             
-    std::string postInfo = std::string("\nExample: lumaplay --input hdr_video.mkv -s 0.2 -g 1.8 -fps 25\n\n") +
+    std::string postInfo = std::string("\nExample: lumaplay --input hdr_video.mkv -s 0.2 -g 1.8 -fps 25\n") +
+                           std::string("         lumaplay --input hdr_video.mkv --headless -o frame_%05d.png\n\n") +
                            std::string("See man page for more information.");
     
     try
@@ -176,11 +277,25 @@ int main(int argc, char** argv)
         argHolder.add(&gammaVal,          "--gamma",     "-g",   "Display gamma value", 2.2f);
         argHolder.add(&userScaling,       "--scaling",   "-s",   "Scaling to apply to video", 1.0f);
         argHolder.add(&global::state.fps, "--framerate", "-fps", "Framerate (frames/s)", global::state.fps);
+        argHolder.add(&global::state.exposure, "--exposure", "-e", "Exposure (scaling of the displayed values)", global::state.exposure);
+        argHolder.add(&global::state.doTmo, "--tone-curve", "-tc", "Apply simple sigmoid tone curve");
+        argHolder.add(&traceFile,         "--trace",     "-tr",  "Write a Chrome trace of the playback to a JSON file");
+        argHolder.add(&headless,          "--headless",  "-hl",  "Render offscreen, without a window, as fast as possible");
+        argHolder.add(&outputFile,        "--output",    "-o",   "Headless output frames, as PNG or EXR (e.g. frame_%05d.png)");
+        argHolder.add(&maxFrames,         "--frames",    "-f",   "Number of frames to render headless (0 for all)");
+        argHolder.add(&linear,            "--linear",    "-l",   "Render linear values, without tone curve and gamma (headless)");
         
         // Parse arguments
         if (!argHolder.read(argc, argv))
             return 0;    
         
+        if (!headless && (!outputFile.empty() || maxFrames || linear))
+            throw ParserException("Output, frames and linear rendering are only available with --headless");
+        
+        // Event tracing, from command line or the LUMA_TRACE environment variable
+        if (!LumaTrace::start(traceFile.c_str()))
+            LumaTrace::startFromEnv();
+        
         // Initialize decoder    
         if (!global::state.decoder.initialize(inputFile.c_str()))
             return 1;
@@ -201,6 +316,13 @@ int main(int argc, char** argv)
         global::state.strideRatio = ((float)global::state.stride[0])/global::state.width[0];
         if (global::state.hbd) global::state.strideRatio /= 2;
         
+        // Offscreen rendering and export, or benchmarking
+        if (headless)
+        {
+            renderHeadless(outputFile, maxFrames, linear, gammaVal, userScaling);
+            return 0;
+        }
+        
         // Initialize GLUT and GLEW
         glutInit(&argc, argv);
         glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
@@ -221,6 +343,13 @@ int main(int argc, char** argv)
         glutMotionFunc(mouseMotion);
         glutPassiveMotionFunc(mousePassiveMotion);
         
+        // Start decoding, and presentation of the decoded frames
+        for (unsigned int i=0; i<global::upload.size; i++)
+            global::playback.uploading.push_back(i);
+        requestFrames();
+        global::playback.thread = std::thread(decodeFrames);
+        glutTimerFunc(0, present, 0);
+        
         // Start the rendering loop
         glutMainLoop();
     }
@@ -262,6 +391,54 @@ int loadTexture(GLuint t)
     return object;
 }
 
+// Setup the textures of the decoded frames, and the PBOs they are uploaded
+// from. The textures are allocated once, with immutable storage if possible
+void setupFrameTextures()
+{
+    const GLenum internalFormat = global::state.hbd ? GL_R16 : GL_R8;
+    const unsigned int bytes = global::state.hbd ? 2 : 1;
+    GLuint tex[] = {global::state.texC1, global::state.texC2, global::state.texC3};
+    
+    global::upload.frameBytes = 0;
+    for (unsigned int p=0; p<3; p++)
+    {
+        glBindTexture(GL_TEXTURE_2D, tex[p]);
+        if (GLEW_ARB_texture_storage)
+            glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, global::state.stride[p]/bytes, global::state.height[p]);
+        else
+            glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, global::state.stride[p]/bytes, global::state.height[p],
+                         0, GL_RED, bytes > 1 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE, NULL);
+        
+        global::upload.offset[p] = global::upload.frameBytes;
+        global::upload.frameBytes += (size_t)global::state.stride[p]*global::state.height[p];
+    }
+    
+    // Rows are packed with the stride of the decoded frame
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    
+    global::upload.persistent = GLEW_ARB_buffer_storage;
+    glGenBuffers(global::upload.size, global::upload.pbo);
+    for (unsigned int i=0; i<global::upload.size; i++)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, global::upload.pbo[i]);
+        global::upload.mapped[i] = NULL;
+        global::upload.fence[i] = 0;
+        
+        if (global::upload.persistent)
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, global::upload.frameBytes, NULL, flags);
+            global::upload.mapped[i] = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+                                                                        global::upload.frameBytes, flags);
+            if (global::upload.mapped[i] == NULL)
+                throw LumaException("unable to map pixel buffer object");
+        }
+        else
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, global::upload.frameBytes, NULL, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
 // Setup a GLSL shader
 bool setupShader(GLuint &shader, GLuint &program, const GLchar** shader_src)
 {
@@ -366,6 +543,7 @@ void init(float gammaVal, float userScaling)
     global::state.texC2 = loadTexture(GL_TEXTURE_2D);
     global::state.texC3 = loadTexture(GL_TEXTURE_2D);
     global::state.texM = loadTexture(GL_TEXTURE_1D);
+    setupFrameTextures();
     
     glBindTexture(GL_TEXTURE_1D,global::state.texM);
     glTexImage1D(GL_TEXTURE_1D,0,GL_R32F,global::state.decoder.getQuantizer()->getSize(),
@@ -409,6 +587,7 @@ void init(float gammaVal, float userScaling)
     glUniform1i(glGetUniformLocation(global::state.dequantProg, "colorSpace"), colorSpace);
     glUniform1i(glGetUniformLocation(global::state.dequantProg, "doTmo"), global::state.doTmo);
     glUniform1i(glGetUniformLocation(global::state.dequantProg, "ldrSim"), global::state.ldrSim);
+    glUniform1i(glGetUniformLocation(global::state.dequantProg, "linear"), 0);
     
     // GUI shader params
     glUseProgram(global::state.guiProg);
@@ -425,27 +604,206 @@ void init(float gammaVal, float userScaling)
 
 // === Utility functions for use during playback ===============================
 
-// Get a frame from the decoder
-bool getFrame()
+// Time in ms, from a monotonic clock
+double timeMs()
 {
-    // End of clip. Start from first frame
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Get a frame from the decoder. Runs in the decoder thread
+bool getFrame(global::DecodedFrame &frame)
+{
+    static unsigned int frameNr = 0;
+    
+    // Seek requested by the GLUT thread. The frame belongs to the generation
+    // of the last seek applied here, so that the first frame after a seek is
+    // not discarded
+    float seekTime;
+    {
+        std::unique_lock<std::mutex> lock(global::playback.mutex);
+        seekTime = global::playback.seekTime;
+        global::playback.seekTime = -1.0f;
+        frame.generation = global::playback.generation;
+    }
+    if (seekTime >= 0.0f)
+    {
+        global::state.decoder.seekToTime(seekTime);
+        float duration = global::state.decoder.getReader()->getFrameDuration();
+        frameNr = seekTime*(global::state.duration-duration)/duration;
+    }
+    
+    // End of clip. Start from first frame, unless rendering headless
     if (!global::state.decoder.run())
     {
+        if (!global::playback.loop)
+            return 0;
         global::state.decoder.seekToTime(0);
-        global::state.inactiveTime -= (global::state.frameNr-1)*global::state.frameDuration;
-        global::state.frameNr = 0;
+        frameNr = 0;
         if (!global::state.decoder.run())
             return 0;
     }
     
     // Get frame and frame duration
-    global::state.decoder.getFrame();
-    global::state.frameDuration = global::state.decoder.getReader()->getFrameDuration();
-    global::state.frameNr++;
+    frame.duration = global::state.decoder.getReader()->getFrameDuration();
+    frame.frameNr = ++frameNr;
+    
+    return 1;
+}
+
+// Decoder thread. Decodes frames to the free PBOs, until stopped
+void decodeFrames()
+{
+    try
+    {
+        while (1)
+        {
+            global::DecodedFrame frame;
+            {
+                std::unique_lock<std::mutex> lock(global::playback.mutex);
+                while (!global::playback.stop && global::playback.free.empty())
+                    global::playback.slotFree.wait(lock);
+                if (global::playback.stop)
+                    return;
+                frame.slot = global::playback.free.front();
+                global::playback.free.pop_front();
+            }
+            
+            double start = timeMs();
+            bool gotFrame;
+            {
+                LumaTraceScope trace("get_frame");
+                gotFrame = getFrame(frame);
+                if (gotFrame)
+                    fillUploadSlot(global::upload.mapped[frame.slot]);
+            }
+            frame.decodeTime = timeMs() - start;
+            
+            std::unique_lock<std::mutex> lock(global::playback.mutex);
+            if (!gotFrame)
+            {
+                global::playback.end = true;
+                global::playback.frameReady.notify_one();
+                return;
+            }
+            
+            // Frames decoded before a seek are discarded
+            if (frame.generation == global::playback.generation)
+            {
+                global::playback.ready.push_back(frame);
+                global::playback.frameReady.notify_one();
+            }
+            else
+                global::playback.free.push_back(frame.slot);
+        }
+    }
+    catch (std::exception &e)
+    {
+        std::unique_lock<std::mutex> lock(global::playback.mutex);
+        global::playback.error = e.what();
+        global::playback.end = true;
+        global::playback.frameReady.notify_one();
+    }
+}
+
+// Stop the decoder thread, before exiting
+void stopDecoding()
+{
+    {
+        std::unique_lock<std::mutex> lock(global::playback.mutex);
+        global::playback.stop = true;
+    }
+    global::playback.slotFree.notify_one();
+    if (global::playback.thread.joinable())
+        global::playback.thread.join();
+}
+
+// Hand the PBOs that the GL is done uploading from to the decoder thread.
+// With wait set, the oldest upload is waited for, so that at least one PBO
+// is handed over if there are any uploads in flight
+void requestFrames(bool wait)
+{
+    unsigned int n = 0;
+    while (!global::playback.uploading.empty() && mapUploadSlot(global::playback.uploading.front(), wait && !n))
+    {
+        std::unique_lock<std::mutex> lock(global::playback.mutex);
+        global::playback.free.push_back(global::playback.uploading.front());
+        global::playback.uploading.pop_front();
+        n++;
+    }
+    
+    if (n)
+        global::playback.slotFree.notify_one();
+}
+
+// Map a PBO of the ring, for writing a decoded frame, once the previous
+// upload from the PBO has finished. Returns false if the upload is still in
+// progress, and wait is not set
+bool mapUploadSlot(unsigned int slot, bool wait)
+{
+    if (global::upload.fence[slot])
+    {
+        GLenum res;
+        while ((res = glClientWaitSync(global::upload.fence[slot], GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000 : 0))
+               == GL_TIMEOUT_EXPIRED)
+        {
+            if (!wait)
+                return 0;
+        }
+        glDeleteSync(global::upload.fence[slot]);
+        global::upload.fence[slot] = 0;
+        if (res == GL_WAIT_FAILED)
+            throw LumaException("failed to wait for texture upload");
+    }
+    
+    if (global::upload.persistent)
+        return 1;
+    
+    // The old storage is orphaned, so that mapping does not stall
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, global::upload.pbo[slot]);
+    global::upload.mapped[slot] = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, global::upload.frameBytes,
+                                                                   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (global::upload.mapped[slot] == NULL)
+        throw LumaException("unable to map pixel buffer object");
     
     return 1;
 }
 
+// Copy the planes of the decoded frame to a PBO. Runs in the decoder thread
+void fillUploadSlot(unsigned char *dest)
+{
+    for (unsigned int p=0; p<3; p++)
+        memcpy(dest + global::upload.offset[p], global::state.decoder.getBuffer()[p],
+               (size_t)global::state.stride[p]*global::state.height[p]);
+}
+
+// Upload the frame in a PBO to the textures. The copy is made by the GL,
+// asynchronously to the CPU
+void uploadFrame(unsigned int slot)
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, global::upload.pbo[slot]);
+    if (!global::upload.persistent)
+    {
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        global::upload.mapped[slot] = NULL;
+    }
+    
+    const unsigned int bytes = global::state.hbd ? 2 : 1;
+    GLuint tex[] = {global::state.texC1, global::state.texC2, global::state.texC3};
+    for (unsigned int p=0; p<3; p++)
+    {
+        glActiveTexture(GL_TEXTURE0 + p);
+        glBindTexture(GL_TEXTURE_2D, tex[p]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, global::state.stride[p]/bytes, global::state.height[p],
+                        GL_RED, bytes > 1 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE,
+                        (const GLvoid*)global::upload.offset[p]);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    
+    global::upload.fence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
 // inactiveTime stores the timestamp for the last interaction with the window
 void resetGuiTime()
 {
@@ -453,12 +811,37 @@ void resetGuiTime()
 }
 
 // Seeking to a time in the video sequence
+// The seek is made by the decoder thread, and the decoded frames that are
+// waiting are discarded. The first frame after the seek is shown also if
+// the video is paused
 void seekToTime(float time)
 {
-    global::state.decoder.seekToTime(time);
+    {
+        std::unique_lock<std::mutex> lock(global::playback.mutex);
+        global::playback.seekTime = time;
+        global::playback.generation++;
+        while (!global::playback.ready.empty())
+        {
+            global::playback.free.push_back(global::playback.ready.front().slot);
+            global::playback.ready.pop_front();
+        }
+    }
+    global::playback.slotFree.notify_one();
+    global::playback.showNext = true;
+    global::playback.lastPresent = -1.0;
+    
     global::state.frameNr = time*(global::state.duration-global::state.frameDuration)
                                 /global::state.frameDuration + 1;
-    global::state.seek = true;
+    resetGuiTime();
+    glutPostRedisplay();
+}
+
+// The presentation clock is restarted when the playback is resumed
+void togglePause()
+{
+    global::state.pausePlayback = !global::state.pausePlayback;
+    global::playback.clockValid = false;
+    global::playback.lastPresent = -1.0;
     resetGuiTime();
     glutPostRedisplay();
 }
@@ -493,115 +876,440 @@ bool positionSlider(unsigned int x)
 
 
 
-// === Callback functions ======================================================
+// === Offscreen rendering =====================================================
 
-// On redraw
-void display()
+// Create a GL context without a window. The Mesa surfaceless platform is used
+// if available, which needs neither a display server nor a GPU
+void createHeadlessContext()
 {
-    // Timings, for information and synchronization of framerate
-    if (global::state.frameNr > 0 && !global::state.pausePlayback)
+#ifdef HAVE_EGL
+    EGLDisplay display = EGL_NO_DISPLAY;
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay != NULL)
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+#endif
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+        throw LumaException("unable to initialize EGL display");
+    if (!eglBindAPI(EGL_OPENGL_API))
+        throw LumaException("EGL does not support OpenGL");
+    
+    // The frames are rendered to a framebuffer object, so the context is
+    // made current without a surface
+    const EGLint attribs[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config;
+    EGLint n = 0;
+    if (!eglChooseConfig(display, attribs, &config, 1, &n) || !n)
+        config = EGL_NO_CONFIG_KHR;
+    
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        throw LumaException("unable to create EGL context");
+#else
+    throw LumaException("lumaplay was built without EGL, and cannot render headless");
+#endif
+}
+
+// Render the video offscreen, as fast as possible. The frames are decoded and
+// uploaded as during playback, and the dequantization shader renders them to
+// a framebuffer object of the video size. With an output file, the frames are
+// read back and written as PNG (display values) or EXR (linear values), and
+// otherwise only the rendering frame rate is measured
+void renderHeadless(const std::string &outputFile, unsigned int maxFrames, bool linear,
+                    float gammaVal, float userScaling)
+{
+    const unsigned int w = global::state.width[0], h = global::state.height[0];
+    
+    bool exr = false;
+    if (!outputFile.empty())
     {
-        gettimeofday(&global::state.stop, NULL);
-        
-        float dispTime = (global::state.stop.tv_sec-global::state.start2.tv_sec)*1000.0f 
-                       + (global::state.stop.tv_usec-global::state.start2.tv_usec)/1000.0f;
-        float totTime = (global::state.stop.tv_sec-global::state.start1.tv_sec)*1000.0f
-                      + (global::state.stop.tv_usec-global::state.start1.tv_usec)/1000.0f;
-        
-        global::state.dispTimeTot = (global::state.dispTimeTot*global::state.frameNr +  dispTime)
-                                   /(global::state.frameNr+1);
-        global::state.totTimeTot = (global::state.totTimeTot*global::state.frameNr +  totTime)
-                                   /(global::state.frameNr+1);
-        
-        if (global::state.showTimings)
+        size_t dot = outputFile.find_last_of('.');
+        std::string ext = dot == std::string::npos ? "" : outputFile.substr(dot+1);
+        if (!strcasecmp(ext.c_str(), "exr"))
+            exr = linear = true;
+        else if (strcasecmp(ext.c_str(), "png") || linear)
+            throw ParserException("Headless output is written as PNG, or as EXR for linear rendering");
+#ifndef HAVE_OPENEXR
+        if (exr)
+            throw ParserException("lumaplay was built without OpenEXR, and cannot write EXR frames");
+#endif
+    }
+    
+    createHeadlessContext();
+    
+    // GLEW built for GLX reports a missing display without X, but the GL
+    // functions are loaded regardless
+    glewInit();
+    if (glGenFramebuffers == NULL)
+        throw LumaException("unable to load OpenGL functions");
+    fprintf(stderr, "OpenGL version : %s\n",  (char*)glGetString(GL_VERSION));
+    
+    init(gammaVal, userScaling);
+    
+    // Framebuffer of the video size, with float storage for linear values
+    GLuint fbo, rbo;
+    glGenRenderbuffers(1, &rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, linear ? GL_RGBA32F : GL_RGBA8, w, h);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rbo);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw LumaException("unable to create framebuffer for offscreen rendering");
+    
+    reshape(w, h);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glUseProgram(global::state.dequantProg);
+    glUniform1i(glGetUniformLocation(global::state.dequantProg, "linear"), linear);
+    
+    std::vector<unsigned char> pixels(outputFile.empty() || exr ? 0 : 3*(size_t)w*h);
+    std::vector<float> pixelsLinear(exr ? 3*(size_t)w*h : 0);
+#ifdef HAVE_OPENEXR
+    LumaFrame exrFrame(exr ? w : 0, h);
+#endif
+    
+    // Decode the clip once, without looping
+    global::playback.loop = false;
+    for (unsigned int i=0; i<global::upload.size; i++)
+        global::playback.uploading.push_back(i);
+    requestFrames();
+    global::playback.thread = std::thread(decodeFrames);
+    
+    unsigned int rendered = 0;
+    double start = timeMs(), decodeSum = 0.0;
+    try
+    {
+        while (!maxFrames || rendered < maxFrames)
         {
-            fprintf(stderr, "DISPLAY TIME: %f (avg = %f)\n",
-                    dispTime, global::state.dispTimeTot);
-            fprintf(stderr, "TOTAL TIME:   %f (avg = %f), %f fps\n",
-                    totTime, global::state.totTimeTot, 1000.0f/totTime);
+            // Wait for the oldest upload, if the decoder has no PBO to decode to
+            bool starved;
+            {
+                std::unique_lock<std::mutex> lock(global::playback.mutex);
+                starved = global::playback.ready.empty() && global::playback.free.empty();
+            }
+            requestFrames(starved);
+            
+            global::DecodedFrame frame;
+            {
+                std::unique_lock<std::mutex> lock(global::playback.mutex);
+                while (global::playback.ready.empty() && !global::playback.end)
+                    global::playback.frameReady.wait(lock);
+                if (!global::playback.error.empty())
+                {
+                    std::string error = global::playback.error;
+                    throw LumaException(error.c_str());
+                }
+                if (global::playback.ready.empty())
+                    break;
+                frame = global::playback.ready.front();
+                global::playback.ready.pop_front();
+            }
+            
+            {
+                LumaTraceScope trace("render", frame.frameNr);
+                uploadFrame(frame.slot);
+                global::playback.uploading.push_back(frame.slot);
+                
+                glClear(GL_COLOR_BUFFER_BIT);
+                drawFrame();
+            }
+            
+            if (!outputFile.empty())
+            {
+                LumaTraceScope trace("write_frame", frame.frameNr);
+                char name[1024];
+                snprintf(name, sizeof(name), outputFile.c_str(), frame.frameNr);
+                
+                bool written = false;
+                if (exr)
+                {
+                    glReadPixels(0, 0, w, h, GL_RGB, GL_FLOAT, &pixelsLinear[0]);
+#ifdef HAVE_OPENEXR
+                    // Interleaved bottom-up rows, to planar top-down
+                    for (unsigned int y=0; y<h; y++)
+                        for (unsigned int x=0; x<w; x++)
+                            for (unsigned int c=0; c<3; c++)
+                                exrFrame.getChannel(c)[y*w + x] = pixelsLinear[3*((h-1-y)*w + x) + c];
+                    written = ExrInterface::writeFrame(name, exrFrame);
+#endif
+                }
+                else
+                {
+                    glReadPixels(0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+                    written = writePng(name, &pixels[0], w, h);
+                }
+                
+                if (!written)
+                {
+                    std::string error = std::string("unable to write frame ") + name;
+                    throw LumaException(error.c_str());
+                }
+            }
+            
+            rendered++;
+            decodeSum += frame.decodeTime;
         }
-        
-        // Waiting time for next frame
-        float sleepTime = global::state.frameDuration-totTime, t = 0.0f;
-        if (global::state.fps > 0.0f)
-            sleepTime = 1000.0f/global::state.fps-totTime;
-        
-        // Very ugly way to accomplish the sought frame rate
-        //TODO: use glutTimerFunc instead...?
-        while (sleepTime > t)
+        glFinish();
+    }
+    catch (...)
+    {
+        stopDecoding();
+        throw;
+    }
+    
+    double time = timeMs() - start;
+    stopDecoding();
+    
+    if (!rendered)
+        throw LumaException("no frames to render");
+    
+    fprintf(stderr, "Rendered %u frames (%ux%u) in %.2f s: %.1f fps (%.2f ms/frame), decoding: %.2f ms/frame\n",
+            rendered, w, h, time/1000.0, 1000.0*rendered/time, time/rendered, decodeSum/rendered);
+}
+
+// CRC of a PNG chunk, over the chunk type and data
+static unsigned int pngCrc(const unsigned char *data, size_t size, unsigned int crc)
+{
+    static unsigned int table[256] = {0};
+    if (!table[1])
+        for (unsigned int n=0; n<256; n++)
         {
-            gettimeofday(&global::state.start1, NULL);
-            t = (global::state.start1.tv_sec-global::state.stop.tv_sec)*1000.0f
-              + (global::state.start1.tv_usec-global::state.stop.tv_usec)/1000.0f;
+            unsigned int c = n;
+            for (int k=0; k<8; k++)
+                c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
         }
-    }
     
-    gettimeofday(&global::state.start1, NULL);
+    for (size_t i=0; i<size; i++)
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+static void pngChunk(std::vector<unsigned char> &png, const char *type, const std::vector<unsigned char> &data)
+{
+    const size_t size = data.size(), start = png.size() + 4;
+    unsigned char sizeBytes[] = {(unsigned char)(size >> 24), (unsigned char)(size >> 16),
+                                 (unsigned char)(size >> 8), (unsigned char)size};
+    png.insert(png.end(), sizeBytes, sizeBytes + 4);
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), data.begin(), data.end());
     
-    bool gotFrame = 0;
+    unsigned int crc = ~pngCrc(&png[start], size + 4, 0xffffffffu);
+    unsigned char crcBytes[] = {(unsigned char)(crc >> 24), (unsigned char)(crc >> 16),
+                                (unsigned char)(crc >> 8), (unsigned char)crc};
+    png.insert(png.end(), crcBytes, crcBytes + 4);
+}
+
+// Write an 8-bit RGB PNG, from rows in bottom-up order as read from the GL.
+// The rows are stored uncompressed, in deflate blocks of type 0, which keeps
+// the writing fast and free of dependencies
+bool writePng(const char *file, const unsigned char *rgb, unsigned int w, unsigned int h)
+{
+    const size_t rowBytes = 3*(size_t)w + 1;
+    const unsigned char signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::vector<unsigned char> png(signature, signature + 8), header(13, 0), data;
     
-    // Get next frame, if video is not paused
-    if (!global::state.pausePlayback || global::state.seek)
+    header[0] = w >> 24; header[1] = w >> 16; header[2] = w >> 8; header[3] = w;
+    header[4] = h >> 24; header[5] = h >> 16; header[6] = h >> 8; header[7] = h;
+    header[8] = 8; // bit depth
+    header[9] = 2; // RGB
+    pngChunk(png, "IHDR", header);
+    
+    // zlib stream, with each row preceded by filter type 0
+    data.reserve(h*rowBytes + 6 + 5*(h*rowBytes/65535 + 1));
+    data.push_back(0x78);
+    data.push_back(0x01);
+    unsigned int a = 1, b = 0;
+    size_t blockLeft = 0;
+    for (unsigned int y=0; y<h; y++)
     {
-        gotFrame = getFrame();
-        global::state.seek = false;
+        const unsigned char *row = rgb + (size_t)(h-1-y)*3*w;
+        for (size_t i=0; i<rowBytes; i++)
+        {
+            if (!blockLeft)
+            {
+                size_t remaining = (h-y)*rowBytes - i;
+                blockLeft = std::min(remaining, (size_t)65535);
+                data.push_back(blockLeft == remaining);
+                data.push_back(blockLeft & 0xff);
+                data.push_back(blockLeft >> 8);
+                data.push_back(~blockLeft & 0xff);
+                data.push_back((~blockLeft >> 8) & 0xff);
+            }
+            
+            unsigned char v = i ? row[i-1] : 0;
+            data.push_back(v);
+            a = (a + v) % 65521;
+            b = (b + a) % 65521;
+            blockLeft--;
+        }
     }
+    unsigned int adler = (b << 16) | a;
+    data.push_back(adler >> 24);
+    data.push_back(adler >> 16);
+    data.push_back(adler >> 8);
+    data.push_back(adler);
+    pngChunk(png, "IDAT", data);
+    pngChunk(png, "IEND", std::vector<unsigned char>());
     
-    gettimeofday(&global::state.start2, NULL);
+    FILE *f = fopen(file, "wb");
+    if (f == NULL)
+        return 0;
+    bool ok = fwrite(&png[0], 1, png.size(), f) == png.size();
+    return fclose(f) == 0 && ok;
+}
+
+// =============================================================================
+
+
+
+
+
+// === Callback functions ======================================================
+
+// Present the next decoded frame when it is due, on a timer. Frames that are
+// late are dropped, as long as there is a later frame that is due, so that
+// playback follows the clock also when frames cannot be presented in time
+void present(int)
+{
+    double now = timeMs();
     
-    glClear(GL_COLOR_BUFFER_BIT);
+    // PBOs that have been uploaded from can be decoded to again
+    requestFrames();
     
-    // Load frame to textures, one per color channel
-    if (gotFrame)
+    bool gotFrame = false, dropped = false;
+    global::DecodedFrame frame;
     {
-        if (global::state.hbd)
+        std::unique_lock<std::mutex> lock(global::playback.mutex);
+        if (!global::playback.error.empty())
         {
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D,global::state.texC1);
-            glTexImage2D(GL_TEXTURE_2D,0,GL_R16,global::state.stride[0]/2,global::state.height[0],
-                         0,GL_RED,GL_UNSIGNED_SHORT,(unsigned short*)(global::state.decoder.getBuffer()[0]));
-            
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D,global::state.texC2);
-            glTexImage2D(GL_TEXTURE_2D,0,GL_R16,global::state.stride[1]/2,global::state.height[1],
-                         0,GL_RED,GL_UNSIGNED_SHORT,(unsigned short*)(global::state.decoder.getBuffer()[1]));
-            
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D,global::state.texC3);
-            glTexImage2D(GL_TEXTURE_2D,0,GL_R16,global::state.stride[2]/2,global::state.height[2],
-                         0,GL_RED,GL_UNSIGNED_SHORT,(unsigned short*)(global::state.decoder.getBuffer()[2]));
+            fprintf(stderr, "\nlumaplay decoding error: %s\n", global::playback.error.c_str());
+            lock.unlock();
+            stopDecoding();
+            exit(1);
         }
-        else
+        if (global::playback.end && global::playback.ready.empty() && global::state.frameNr == 0)
         {
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D,global::state.texC1);
-            glTexImage2D(GL_TEXTURE_2D,0,GL_R8,global::state.stride[0],global::state.height[0],
-                         0,GL_RED,GL_UNSIGNED_BYTE,global::state.decoder.getBuffer()[0]);
+            fprintf(stderr, "\nlumaplay: no frames to play\n");
+            lock.unlock();
+            stopDecoding();
+            exit(1);
+        }
+        
+        while (!global::playback.ready.empty() && (!global::state.pausePlayback || global::playback.showNext))
+        {
+            const global::DecodedFrame &next = global::playback.ready.front();
+            const float duration = global::state.fps > 0.0f ? 1000.0f/global::state.fps : next.duration;
+            
+            // Restart the clock after pausing or seeking. At the end of the clip
+            // the clock continues, with the first frame following the last one
+            if (!global::playback.clockValid || global::playback.showNext)
+            {
+                global::playback.clockStart = now - (next.frameNr-1)*duration;
+                global::playback.clockValid = true;
+            }
+            else if (next.frameNr < global::playback.clockFrameNr)
+                global::playback.clockStart += (global::playback.clockFrameNr - next.frameNr + 1)*duration;
+            global::playback.clockFrameNr = next.frameNr;
             
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D,global::state.texC2);
-            glTexImage2D(GL_TEXTURE_2D,0,GL_R8,global::state.stride[1],global::state.height[1],
-                         0,GL_RED,GL_UNSIGNED_BYTE,global::state.decoder.getBuffer()[1]);
+            // Late frame, when the following frame is due as well
+            if (global::playback.ready.size() > 1 && global::playback.ready[1].frameNr > next.frameNr &&
+                global::playback.clockStart + (global::playback.ready[1].frameNr-1)*duration <= now)
+            {
+                global::playback.free.push_back(next.slot);
+                global::playback.ready.pop_front();
+                global::playback.dropped++;
+                dropped = true;
+                continue;
+            }
             
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D,global::state.texC3);
-            glTexImage2D(GL_TEXTURE_2D,0,GL_R8,global::state.stride[2],global::state.height[2],
-                         0,GL_RED,GL_UNSIGNED_BYTE,global::state.decoder.getBuffer()[2]);
+            if (global::playback.clockStart + (next.frameNr-1)*duration <= now)
+            {
+                frame = next;
+                global::playback.ready.pop_front();
+                gotFrame = true;
+                global::state.frameDuration = duration;
+            }
+            break;
+        }
+    }
+    if (dropped)
+        global::playback.slotFree.notify_one();
+    
+    if (gotFrame)
+    {
+        LumaTraceScope trace("upload", frame.frameNr);
+        uploadFrame(frame.slot);
+        global::playback.uploading.push_back(frame.slot);
+        
+        // Looping to the start of the clip
+        if (frame.frameNr < global::state.frameNr)
+            global::state.inactiveTime -= (global::state.frameNr-1)*global::state.frameDuration;
+        global::state.frameNr = frame.frameNr;
+        global::playback.showNext = false;
+        
+        // Frame time statistics
+        if (global::playback.lastPresent >= 0.0)
+        {
+            double t = now - global::playback.lastPresent;
+            global::playback.sum += t;
+            global::playback.sumSq += t*t;
+            global::playback.minTime = std::min(global::playback.minTime, t);
+            global::playback.maxTime = std::max(global::playback.maxTime, t);
+            global::playback.intervals++;
         }
+        global::playback.lastPresent = now;
+        global::playback.presented++;
+        global::playback.decodeSum += frame.decodeTime;
         
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_1D,global::state.texM);
+        glutPostRedisplay();
     }
     
-    glActiveTexture(GL_TEXTURE4);
+    // Report the frame times once per second
+    if (now - global::playback.reportTime >= 1000.0)
+    {
+        const unsigned int n = global::playback.intervals;
+        if (global::state.showTimings && n > 0)
+        {
+            double mean = global::playback.sum/n;
+            double var = std::max(0.0, global::playback.sumSq/n - mean*mean);
+            fprintf(stderr, "FRAME TIME: %.2f ms (std = %.2f, min = %.2f, max = %.2f), %.1f fps, "
+                            "decoding: %.2f ms, dropped: %u\n",
+                    mean, sqrt(var), global::playback.minTime, global::playback.maxTime, 1000.0/mean,
+                    global::playback.decodeSum/global::playback.presented, global::playback.dropped);
+        }
+        global::playback.presented = global::playback.intervals = global::playback.dropped = 0;
+        global::playback.sum = global::playback.sumSq = global::playback.decodeSum = global::playback.maxTime = 0.0;
+        global::playback.minTime = 1e10;
+        global::playback.lastPresent = -1.0;
+        global::playback.reportTime = now;
+    }
     
-    // GUI texture
-    if (global::state.pausePlayback)
-        glBindTexture(GL_TEXTURE_2D,global::state.texGUI2);
-    else
-        glBindTexture(GL_TEXTURE_2D,global::state.texGUI1);
+    // Wake up when the next frame is due, or poll for decoded frames
+    double wait = global::state.pausePlayback && !global::playback.showNext ? 20.0 : 2.0;
+    {
+        std::unique_lock<std::mutex> lock(global::playback.mutex);
+        if (!global::playback.ready.empty() && global::playback.clockValid && !global::state.pausePlayback)
+        {
+            const float duration = global::state.fps > 0.0f ? 1000.0f/global::state.fps : global::playback.ready.front().duration;
+            wait = std::min(std::max(global::playback.clockStart + (global::playback.ready.front().frameNr-1)*duration
+                                     - timeMs(), 0.0), 20.0);
+        }
+    }
+    glutTimerFunc((unsigned int)wait, present, 0);
+}
+
+// Run the dequantization shader on the frame textures
+void drawFrame()
+{
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_1D,global::state.texM);
     
-    // Run dequantization shader on the frame textures
     glUseProgram(global::state.dequantProg);
     glBegin(GL_QUADS);
         glTexCoord2f(0,0);
@@ -613,6 +1321,21 @@ void display()
         glTexCoord2f(0,1);
         glVertex2f(global::state.x0, global::state.y0 + global::state.sy);
     glEnd();
+}
+
+// On redraw
+void display()
+{
+    glClear(GL_COLOR_BUFFER_BIT);
+    
+    drawFrame();
+    
+    // GUI texture
+    glActiveTexture(GL_TEXTURE4);
+    if (global::state.pausePlayback)
+        glBindTexture(GL_TEXTURE_2D,global::state.texGUI2);
+    else
+        glBindTexture(GL_TEXTURE_2D,global::state.texGUI1);
     
     // Run GUI shader on the GUI texture, if it is supposed to be displayed
     if ((global::state.frameNr-1)*global::state.frameDuration - global::state.inactiveTime < global::state.guiTime)
@@ -639,10 +1362,9 @@ void display()
     }
     
     //glFlush();
+    LumaTrace::begin("swap_buffers");
     glutSwapBuffers();
-    
-    if (gotFrame && !global::state.pausePlayback)
-        glutPostRedisplay();
+    LumaTrace::end("swap_buffers");
 }
 
 // On window reshape
@@ -719,8 +1441,7 @@ void mouse(int button, int state, int xi, int yi)
         if (x > global::state.Sx0 && x < global::state.Sx1 
             && y > global::state.Sy0 && y < global::state.Sy1)
         {
-            global::state.pausePlayback = !global::state.pausePlayback;
-            glutPostRedisplay();
+            togglePause();
         }
         
         // Click on maximize button, or by double clicking in the window
@@ -798,14 +1519,13 @@ void keyboard(unsigned char key, int x, int)
     case 27:
     case 17:
     case 23:
+        stopDecoding();
         glutDestroyWindow(global::state.windNr);
         exit(0);
         break;
     // Pause/play
     case ' ':
-        global::state.pausePlayback = !global::state.pausePlayback;
-        resetGuiTime();
-        glutPostRedisplay();
+        togglePause();
         break;
     // Increase exposure
     case '+':
@@ -0,0 +1,238 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#include <luma_decoder.h>
+#include "luma_meta_data.h"
+#include "luma_exception.h"
+#include "arg_parser.h"
+
+#include <string.h>
+#include <cmath>
+#include <vector>
+
+
+// Input/output specific information
+struct IOData
+{
+    IOData() : timing(0)
+    {}
+    
+    std::vector<std::string> inputFiles;
+    std::string outputFile;
+    bool timing;
+};
+
+// Parse parameter options from command line. All arguments that are not
+// options, or values of options, are input videos
+bool setParams(int argc, char* argv[], IOData *io)
+{
+    // Application usage info
+    std::string info = std::string("lumaprobe -- Print the meta data of HDR videos encoded with the HDRv codec, as JSON\n\n") +
+                       std::string("Usage: lumaprobe [options] <hdr_video> [<hdr_video> ...]\n");
+    std::string postInfo = std::string("\nExample: lumaprobe -o videos.json videos/*.mkv\n\n") +
+                           std::string("See man page for more information.");
+    ArgParser argHolder(info, postInfo);
+    
+    // Input arguments
+    argHolder.add(&io->outputFile, "--output", "-o", "Write the JSON to a file, instead of to stdout");
+    argHolder.add(&io->timing,     "--timing", "-t", "Include the time spent on probing each video");
+    
+    std::vector<char*> options(1, argv[0]);
+    for (int i=1; i<argc; i++)
+    {
+        if (argv[i][0] != '-')
+            io->inputFiles.push_back(argv[i]);
+        else
+        {
+            options.push_back(argv[i]);
+            if ((!strcmp(argv[i], "--output") || !strcmp(argv[i], "-o")) && i+1 < argc)
+                options.push_back(argv[++i]);
+        }
+    }
+    
+    // Parse arguments
+    if (!argHolder.read((int)options.size(), &options[0]))
+        return 0;
+    
+    if (io->inputFiles.empty())
+        throw ParserException("No input video");
+    
+    return 1;
+}
+
+// Quote a string for JSON output, with the escapes of RFC 8259
+std::string jsonString(const std::string &str)
+{
+    std::string res = "\"";
+    for (size_t i=0; i<str.size(); i++)
+    {
+        const unsigned char c = str[i];
+        switch (c)
+        {
+        case '"':  res += "\\\""; break;
+        case '\\': res += "\\\\"; break;
+        case '\b': res += "\\b"; break;
+        case '\f': res += "\\f"; break;
+        case '\n': res += "\\n"; break;
+        case '\r': res += "\\r"; break;
+        case '\t': res += "\\t"; break;
+        default:
+            if (c < 0x20)
+            {
+                char hex[8];
+                snprintf(hex, 8, "\\u%04x", c);
+                res += hex;
+            }
+            else
+                res += c;
+        }
+    }
+    return res + "\"";
+}
+
+// Format a number for JSON output. JSON has no infinity or NaN, which are
+// written as null
+std::string jsonNumber(double v, const char *format = "%g")
+{
+    if (!std::isfinite(v))
+        return "null";
+    
+    char str[50];
+    snprintf(str, 50, format, v);
+    return str;
+}
+
+// Add a field to a JSON object, which is closed by the caller
+void addField(std::string &obj, const char *name, const std::string &value)
+{
+    obj += std::string(obj.size() > 1 ? ", " : "") + jsonString(name) + ": " + value;
+}
+
+// Meta data of one video, read without initializing the VP9 decoder
+std::string probe(const std::string &inputFile, bool timing)
+{
+    uint64_t start = lumaTimeNs();
+    
+    MkvInterface reader;
+    LumaMetaData meta;
+    if (!reader.probe(inputFile.c_str()))
+        throw LumaException("No video track found");
+    if (!meta.readAttachments(reader))
+        throw LumaException("Failed to locate Luma HDRv meta data");
+    
+    const float duration = 1e-3f*reader.getDuration();
+    const float frameRate = reader.getFrameDuration() > 0 ? 1000.0f/reader.getFrameDuration() : 0.0f;
+    
+    std::string res = "{";
+    addField(res, "file",           jsonString(inputFile));
+    addField(res, "width",          jsonNumber(reader.getWidth()));
+    addField(res, "height",         jsonNumber(reader.getHeight()));
+    addField(res, "ptf",            jsonString(LumaQuantizer::name(meta.ptf)));
+    addField(res, "color_space",    jsonString(LumaQuantizer::name(meta.colorSpace)));
+    addField(res, "ptf_bitdepth",   jsonNumber(meta.ptfBitDepth));
+    addField(res, "color_bitdepth", jsonNumber(meta.colorBitDepth));
+    addField(res, "min_luminance",  jsonNumber(meta.minLum));
+    addField(res, "max_luminance",  jsonNumber(meta.maxLum));
+    addField(res, "pre_scaling",    jsonNumber(meta.preScaling));
+    addField(res, "duration",       jsonNumber(duration, "%.3f"));
+    addField(res, "frame_rate",     jsonNumber(frameRate, "%.3f"));
+    addField(res, "frames",         jsonNumber(reader.getFrames()));
+    addField(res, "keyframes",      jsonNumber(reader.getKeyFrames()));
+    if (timing)
+        addField(res, "probe_ms",   jsonNumber(1e-6*(lumaTimeNs() - start), "%.3f"));
+    
+    return res + "}";
+}
+
+int main(int argc, char* argv[])
+{
+    // Holder for input/output options
+    IOData io;
+    
+    try
+    {
+        if (!setParams(argc, argv, &io))
+            return 1;
+    }
+    catch (ParserException &e)
+    {
+        fprintf(stderr, "\nlumaprobe input error: %s\n", e.what());
+        return 1;
+    }
+    
+    // A video that cannot be probed is reported in the output, and does not
+    // stop the probing of the other videos
+    bool failed = false;
+    std::string json;
+    for (size_t i=0; i<io.inputFiles.size(); i++)
+    {
+        std::string res;
+        try
+        {
+            res = probe(io.inputFiles[i], io.timing);
+        }
+        catch (std::exception &e)
+        {
+            res = "{";
+            addField(res, "file", jsonString(io.inputFiles[i]));
+            addField(res, "error", jsonString(e.what()));
+            res += "}";
+            fprintf(stderr, "lumaprobe error: %s: %s\n", io.inputFiles[i].c_str(), e.what());
+            failed = true;
+        }
+        
+        if (io.inputFiles.size() == 1)
+            json = res;
+        else
+            json += std::string(i ? ",\n  " : "[\n  ") + res;
+    }
+    if (io.inputFiles.size() > 1)
+        json += "\n]";
+    
+    FILE *fp = stdout;
+    if (io.outputFile.size() > 0 && (fp = fopen(io.outputFile.c_str(), "w")) == NULL)
+    {
+        fprintf(stderr, "\nlumaprobe error: Unable to open output file for writing\n");
+        return 1;
+    }
+    fprintf(fp, "%s\n", json.c_str());
+    if (fp != stdout)
+        fclose(fp);
+    
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,273 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#include <luma_decoder.h>
+#include "transcoder.h"
+#include "luma_exception.h"
+#include "arg_parser.h"
+
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+
+// Determine file extension
+bool hasExtension( const char *file_name, const char *extension )
+{
+    if( file_name == NULL )
+        return false;
+    size_t fn_len = strlen( file_name );
+    size_t ex_len = strlen( extension );
+    
+    if( ex_len >= fn_len )
+        return false;
+    
+    if( strcasecmp( file_name + fn_len - ex_len, extension ) == 0 )
+        return true;
+    
+    return false;
+}
+
+// Input/output specific information
+struct IOData
+{
+    IOData() : frames(0), queueSize(4), codecThreads(0), verbose(0)
+    {}
+    
+    std::string inputFile, outputFile;
+    unsigned int frames, queueSize, codecThreads;
+    bool verbose;
+};
+
+// Parse parameter options from command line. The options before the first
+// --output apply to all renditions, and the options following each --output
+// apply to that rendition only
+bool setParams(int argc, char* argv[], LumaEncoderParams *params, IOData *io)
+{
+    std::string ptf, ptfValues[] = {"PSI", "PQ", "LOG", "HDRVDP", "LINEAR"}; // valid ptf input values
+    std::string cs, csValues[] = {"LUV", "RGB", "YCBCR", "XYZ"}; // valid color space input values
+    unsigned int bdValues[] = {8, 10, 12}; // valid bit depths
+    
+    // Application usage info
+    std::string info = std::string("lumatranscode -- Re-encode a HDR video to one or more HDR videos with different encoding parameters\n\n") +
+                       std::string("Usage: lumatranscode --input <hdr_video> [options] \\\n") +
+                       std::string("                     --output <output_1> [options_1] \\\n") +
+                       std::string("                     --output <output_2> [options_2] ...\n");
+    std::string postInfo = std::string("\nExample: lumatranscode -i hdr_video.mkv -o master.mkv -eb 12 -o proxy.mkv -eb 8 -p 0 -b 2000\n\n") +
+                           std::string("See man page for more information.");
+    ArgParser argHolder(info, postInfo);
+    
+    // Input arguments
+    argHolder.add(&io->inputFile,            "--input",             "-i",   "Input HDR video");
+    argHolder.add(&io->outputFile,           "--output",            "-o",   "Output HDR video. Starts the options of a new rendition");
+    argHolder.add(&io->frames,               "--frames",            "-f",   "Number of frames to transcode. 0 for all frames");
+    argHolder.add(&io->queueSize,            "--queue",             "-qu",  "Number of decoded frames that the decoder can run ahead of the encoders", (unsigned int)(1), (unsigned int)(64));
+    argHolder.add(&io->codecThreads,         "--codec-threads",     "-ct",  "Number of VP9 encoder threads per rendition. 0 for the cores shared between renditions", (unsigned int)(0), (unsigned int)(64));
+    argHolder.add(&params->fps,              "--framerate",         "-fps", "Framerate of video stream, specified as frames/s");
+    argHolder.add(&params->profile,          "--profile",           "-p",   "VP9 encoding profile", (unsigned int)(0), (unsigned int)(3));
+    argHolder.add(&params->quantizerScale,   "--quantizer-scaling", "-q",   "Scaling of the encoding quantization", (unsigned int)(0), (unsigned int)(63));
+    argHolder.add(&params->preScaling,       "--pre-scaling",       "-sc",  "Scaling of pixels to apply before tranformation and encoding", 0.0f, 1e20f);
+    argHolder.add(&params->ptfBitDepth,      "--ptf-bitdepth",      "-pb",  "Bit depth of the perceptual transfer function", (unsigned int)(0), (unsigned int)(16));
+    argHolder.add(&params->colorBitDepth,    "--color-bitdepth",    "-cb",  "Bit depth of the color channels", (unsigned int)(0), (unsigned int)(16));
+    argHolder.add(&ptf,                      "--transfer-function", "-ptf", "The perceptual transfer function used for encoding", ptfValues, 5);
+    argHolder.add(&cs,                       "--color-space",       "-cs",  "Color space for encoding", csValues, 4);
+    argHolder.add(&params->maxLum,           "--max-luminance",     "-ma",  "Maximum luminance in encoding (for PQ and LOG transfer function)", 100.0f, 1e5f);
+    argHolder.add(&params->minLum,           "--min-luminance",     "-mi",  "Minimum luminance in encoding (for PQ and LOG transfer function)", 1e-10f, 99.99f);
+    argHolder.add(&params->bitrate,          "--bitrate",           "-b",   "HDR video stream target bandwidth, in Kb/s", (unsigned int)(0), (unsigned int)(9999));
+    argHolder.add(&params->keyframeInterval, "--keyframe-interval", "-k",   "Interval between keyframes. 0 for automatic keyframes", (unsigned int)(0), (unsigned int)(9999));
+    argHolder.add(&params->maxKeyframeInterval, "--max-keyframe-interval", "-mk", "Maximum interval between automatic keyframes", (unsigned int)(1), (unsigned int)(9999));
+    argHolder.add(&params->sceneCutThreshold, "--scene-cut", "-cut", "Threshold of scene cut detection for automatic keyframes, 0-1. 0 disables the detection", 0.0f, 1.0f);
+    argHolder.add(&params->maxClusterSize,   "--max-cluster-size",  "-mcs", "Maximum size of a Matroska cluster, in KB. 0 for no limit", (unsigned int)(0), (unsigned int)(1048576));
+    argHolder.add(&params->maxClusterDuration, "--max-cluster-duration", "-mcd", "Maximum duration of a Matroska cluster, in s. 0 for no limit", 0.0f, 32.0f);
+    argHolder.add(&params->bitDepth,         "--encoding-bitdepth", "-eb",  "Encoding at 8, 10 or 12 bits", bdValues, 3);
+    argHolder.add(&params->lossLess,         "--lossless",          "-l",   "Enable lossless encoding mode");
+    argHolder.add(&io->verbose,              "--verbose",           "-v",   "Verbose mode");
+    
+    // Parse arguments
+    if (!argHolder.read(argc, argv))
+        return 0;
+    
+    // Translate input strings to enums
+    if (!strcmp(ptf.c_str(), ptfValues[0].c_str()))
+        params->ptf = LumaQuantizer::PTF_PSI;
+    else if (!strcmp(ptf.c_str(), ptfValues[1].c_str()))
+        params->ptf = LumaQuantizer::PTF_PQ;
+    else if (!strcmp(ptf.c_str(), ptfValues[2].c_str()))
+        params->ptf = LumaQuantizer::PTF_LOG;
+    else if (!strcmp(ptf.c_str(), ptfValues[3].c_str()))
+        params->ptf = LumaQuantizer::PTF_JND_HDRVDP;
+    else if (!strcmp(ptf.c_str(), ptfValues[4].c_str()))
+        params->ptf = LumaQuantizer::PTF_LINEAR;
+    
+    if (!strcmp(cs.c_str(), csValues[0].c_str()))
+        params->colorSpace = LumaQuantizer::CS_LUV;
+    else if (!strcmp(cs.c_str(), csValues[1].c_str()))
+        params->colorSpace = LumaQuantizer::CS_RGB;
+    else if (!strcmp(cs.c_str(), csValues[2].c_str()))
+        params->colorSpace = LumaQuantizer::CS_YCBCR;
+    else if (!strcmp(cs.c_str(), csValues[3].c_str()))
+        params->colorSpace = LumaQuantizer::CS_XYZ;
+    
+    return 1;
+}
+
+// Encoding parameters of the input video, as defaults for the renditions
+LumaEncoderParams sourceParams(LumaDecoder &decoder)
+{
+    LumaEncoderParams params;
+    LumaDecoderParams src = decoder.getParams();
+    params.ptf = src.ptf;
+    params.colorSpace = src.colorSpace;
+    params.ptfBitDepth = src.ptfBitDepth;
+    params.colorBitDepth = src.colorBitDepth;
+    params.preScaling = src.preScaling;
+    params.minLum = src.minLum;
+    params.maxLum = src.maxLum;
+    
+    int duration = decoder.getReader()->getFrameDuration();
+    if (duration > 0)
+        params.fps = 1000.0f / duration;
+    
+    return params;
+}
+
+int main(int argc, char* argv[])
+{
+    // Holder for input/output options
+    IOData io;
+    LumaEncoderParams params;
+    
+    try
+    {
+        // Split the arguments at each --output
+        std::vector<int> groups;
+        for (int i=1; i<argc; i++)
+            if (!strcmp(argv[i], "--output") || !strcmp(argv[i], "-o"))
+                groups.push_back(i);
+        groups.push_back(argc);
+        
+        const int globalArgs = groups[0];
+        if (!setParams(globalArgs, argv, &params, &io))
+            return 1;
+        if (io.inputFile.size() == 0)
+            throw ParserException("Missing required option '--input'");
+        if (groups.size() < 2)
+            throw ParserException("Missing required option '--output'");
+        
+        LumaDecoder decoder(io.inputFile.c_str(), io.verbose);
+        
+        // Options before the first --output are parsed again, on top of the
+        // parameters of the input video
+        params = sourceParams(decoder);
+        setParams(globalArgs, argv, &params, &io);
+        
+        Transcoder transcoder(io.queueSize);
+        const unsigned int renditions = (unsigned int)groups.size() - 1;
+        for (unsigned int r=0; r<renditions; r++)
+        {
+            std::vector<char*> args(1, argv[0]);
+            args.insert(args.end(), argv + groups[r], argv + groups[r+1]);
+            
+            IOData renditionIO = io;
+            Rendition rendition;
+            rendition.params = params;
+            if (!setParams((int)args.size(), &args[0], &rendition.params, &renditionIO))
+                return 1;
+            
+            if (renditionIO.inputFile != io.inputFile || renditionIO.frames != io.frames ||
+                renditionIO.queueSize != io.queueSize)
+                throw ParserException("Input, frames and queue options have to be given before the first '--output'");
+            if (!hasExtension(renditionIO.outputFile.c_str(), ".mkv"))
+            {
+                std::string msg = "Unsupported output format of '" + renditionIO.outputFile + "'. HDR video should be stored as Matroska file (.mkv)";
+                throw ParserException(msg);
+            }
+            
+            // The bit depths of the input video may not fit a rendition at
+            // a lower encoding bit depth
+            rendition.params.ptfBitDepth = std::min(rendition.params.ptfBitDepth, rendition.params.bitDepth);
+            rendition.params.colorBitDepth = std::min(rendition.params.colorBitDepth, rendition.params.bitDepth);
+
+            // By default the cores are shared between the renditions
+            rendition.params.threads = renditionIO.codecThreads ? renditionIO.codecThreads :
+                std::max(std::thread::hardware_concurrency() / renditions, 1u);
+            rendition.output = renditionIO.outputFile;
+            transcoder.add(rendition);
+        }
+        
+        fprintf(stderr, "Transcoding %s to %u renditions...\n", io.inputFile.c_str(), renditions);
+        
+        uint64_t start = lumaTimeNs();
+        bool res = transcoder.run(decoder, io.frames, io.verbose);
+        double seconds = (lumaTimeNs() - start) * 1e-9;
+        
+        for (size_t i=0; i<transcoder.renditions().size(); i++)
+        {
+            const Rendition &rendition = transcoder.renditions()[i];
+            if (rendition.failed)
+                fprintf(stderr, "  %s failed: %s\n", rendition.output.c_str(), rendition.error.c_str());
+            else
+                fprintf(stderr, "  %s: %u frames, %u bits\n", rendition.output.c_str(),
+                        rendition.frames, rendition.params.bitDepth);
+        }
+        
+        fprintf(stderr, "\nTranscoding finished. %u frames decoded in %.2f s (%.1f fps).\n",
+                transcoder.decodedFrames(), seconds, seconds > 0.0 ? transcoder.decodedFrames() / seconds : 0.0);
+        
+        if (!res)
+            return 1;
+    }
+    catch (ParserException &e)
+    {
+        fprintf(stderr, "\nlumatranscode input error: %s\n", e.what());
+        return 1;
+    }
+    catch (LumaException &e)
+    {
+        fprintf(stderr, "\nlumatranscode error: %s\n", e.what());
+        return 1;
+    }
+    catch (std::exception & e)
+    {
+        fprintf(stderr, "\nlumatranscode error: %s\n", e.what());
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#include "batch_encoder.h"
+#include "exr_interface.h"
+#include "luma_exception.h"
+#include "luma_trace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+
+// By default half of the cores run jobs, and the VP9 threads of the encoders
+// share the cores
+static unsigned int defaultWorkers()
+{
+    return std::max(std::thread::hardware_concurrency() / 2, 1u);
+}
+
+BatchEncoder::BatchEncoder(unsigned int workers, unsigned int codecThreads) :
+    m_next(0), m_workers(workers ? workers : defaultWorkers()),
+    m_codecThreads(codecThreads ? codecThreads : std::max(std::thread::hardware_concurrency() / m_workers, 1u)),
+    m_finished(0), m_pool(m_workers)
+{}
+
+std::string BatchEncoder::fileName(const BatchJob &job, unsigned int ind)
+{
+    char str[500];
+    snprintf(str, 499, job.input.c_str(), job.startFrame + ind*job.stepFrame);
+    return std::string(str);
+}
+
+// Frame size and number of frames of a job, for the scheduling. The sequence
+// ends at the end frame, or at the first missing file
+void BatchEncoder::probe(BatchJob &job)
+{
+    const unsigned int step = std::max(job.stepFrame, 1u);
+    const unsigned int count = job.endFrame >= job.startFrame ? (job.endFrame - job.startFrame) / step + 1 : 0;
+    job.stepFrame = step;
+    
+    if (strcmp(job.input.c_str(), "__test__") == 0)
+    {
+        LumaFrame frame;
+        ExrInterface::testFrame(frame);
+        job.width = frame.width;
+        job.height = frame.height;
+        job.count = count;
+        return;
+    }
+    
+    for (job.count = 0; job.count < count; job.count++)
+    {
+        FILE *fp = fopen(fileName(job, job.count).c_str(), "rb");
+        if (fp == NULL)
+            break;
+        fclose(fp);
+    }
+    
+    if (!job.count)
+        throw LumaException(("No input frames found for '" + job.input + "'").c_str());
+    
+    ExrInterface::readSize(fileName(job, 0).c_str(), job.width, job.height);
+}
+
+// Run all jobs. Returns false if any of the jobs failed
+bool BatchEncoder::run()
+{
+    std::vector<double> cost(m_jobs.size(), 0.0);
+    m_order.clear();
+    for (size_t i=0; i<m_jobs.size(); i++)
+    {
+        try
+        {
+            probe(m_jobs[i]);
+            cost[i] = (double)m_jobs[i].count*m_jobs[i].width*m_jobs[i].height;
+            m_order.push_back(i);
+        }
+        catch (std::exception &e)
+        {
+            m_jobs[i].failed = true;
+            m_jobs[i].error = e.what();
+            fprintf(stderr, "Job %lu (%s) failed: %s\n", (unsigned long)i+1, m_jobs[i].output.c_str(), e.what());
+        }
+    }
+    
+    // Longest job first
+    std::stable_sort(m_order.begin(), m_order.end(),
+                     [&cost](size_t a, size_t b) { return cost[a] > cost[b]; });
+    
+    m_next = 0;
+    m_finished = 0;
+    std::vector<std::thread> threads;
+    for (unsigned int i=0; i<std::min((size_t)m_workers, m_order.size()); i++)
+        threads.push_back(std::thread(&BatchEncoder::worker, this));
+    for (size_t i=0; i<threads.size(); i++)
+        threads[i].join();
+    
+    m_pool.clear();
+    
+    for (size_t i=0; i<m_jobs.size(); i++)
+        if (m_jobs[i].failed)
+            return false;
+    
+    return true;
+}
+
+// Take the next job from the queue, until all jobs have been started
+void BatchEncoder::worker()
+{
+    while (1)
+    {
+        size_t ind;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_next >= m_order.size())
+                return;
+            ind = m_order[m_next++];
+        }
+        
+        BatchJob &job = m_jobs[ind];
+        encode(job);
+        
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_finished++;
+        if (job.failed)
+            fprintf(stderr, "[%u/%lu] %s failed: %s\n", m_finished, (unsigned long)m_order.size(),
+                    job.output.c_str(), job.error.c_str());
+        else
+            fprintf(stderr, "[%u/%lu] %s: %u frames in %.2f s (%.1f fps)\n", m_finished, (unsigned long)m_order.size(),
+                    job.output.c_str(), job.frames, job.seconds, job.seconds > 0.0 ? job.frames / job.seconds : 0.0);
+    }
+}
+
+void BatchEncoder::encode(BatchJob &job)
+{
+    LumaTraceScope trace("batch_job");
+    uint64_t start = lumaTimeNs();
+    
+    // The encoder is created per job, since the VP9 codec and the output are
+    // specific to a stream, while the frame buffers are shared by the workers
+    LumaEncoder encoder;
+    LumaEncoderParams params = job.params;
+    if (!params.threads)
+        params.threads = m_codecThreads;
+    encoder.setParams(params);
+    
+    // The frame buffer is recycled from previous jobs of the same size
+    LumaFrame frame = m_pool.acquire(job.width, job.height);
+    
+    try
+    {
+        for (unsigned int i=0; i<job.count; i++)
+        {
+            if (strcmp(job.input.c_str(), "__test__") == 0)
+                ExrInterface::testFrame(frame);
+            else
+                ExrInterface::readFrame(fileName(job, i).c_str(), frame);
+            
+            if (!encoder.initialized() && !encoder.initialize(job.output.c_str(), frame.width, frame.height))
+                throw LumaException("Failed to initialize encoder");
+            
+            encoder.encode(&frame);
+            job.frames++;
+        }
+        
+        encoder.finish();
+    }
+    catch (std::exception &e)
+    {
+        job.failed = true;
+        job.error = e.what();
+    }
+    
+    m_pool.release(std::move(frame));
+    job.seconds = (lumaTimeNs() - start) * 1e-9;
+}
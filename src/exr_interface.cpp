@@ -38,9 +38,17 @@
 
 #include "exr_interface.h"
 #include "luma_exception.h"
+#include "luma_trace.h"
 
-#include <ImfRgbaFile.h>
-#include <ImfArray.h>
+#include <ImfHeader.h>
+#include <ImfInputFile.h>
+#include <ImfOutputFile.h>
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfThreading.h>
+
+#include <string.h>
+#include <sys/time.h>
 
 using namespace Imf;
 using namespace Imath;
@@ -49,10 +57,7 @@ using namespace Imath;
 // Generate a test frame
 bool ExrInterface::testFrame(LumaFrame &frame, unsigned int w, unsigned int h)
 {
-    frame.width = w;
-    frame.height = h;
-    frame.channels = 3;
-    if (!frame.init())
+    if (!frame.resize(w, h, 3))
         throw LumaException("Cannot allocate memory for input frame");
     
     for (size_t y=0; y<h; y++)
@@ -69,113 +74,139 @@ bool ExrInterface::testFrame(LumaFrame &frame, unsigned int w, unsigned int h)
     return 1;
 }
 
+// Read the size of an exr frame, from the header only
+bool ExrInterface::readSize(const char *inputFile, unsigned int &w, unsigned int &h)
+{
+    try
+    {
+        InputFile file(inputFile);
+        Box2i dw = file.header().dataWindow();
+        w = dw.max.x - dw.min.x + 1;
+        h = dw.max.y - dw.min.y + 1;
+    }
+    catch (const std::exception &e)
+    {
+        throw LumaException(e.what());
+    }
+    
+    return 1;
+}
+
 // Read an exr frame from file
-bool ExrInterface::readFrame(const char *inputFile, LumaFrame &frame)
+//
+// The channels are decoded straight into the planes of the frame, through a
+// frame buffer with float slices. OpenEXR takes care of the half to float
+// conversion, and decompresses scanline blocks in parallel using the global
+// thread pool (see setThreadCount).
+bool ExrInterface::readFrame(const char *inputFile, LumaFrame &frame, float *readTime)
 {
+    LumaTraceScope trace("exr_read");
+    timeval start, stop;
+    gettimeofday(&start, NULL);
+    
     try
     {
-        Array2D<Rgba> pixels;
-        RgbaInputFile file(inputFile);
-        Box2i dw = file.dataWindow();
-        unsigned int w  = dw.max.x - dw.min.x + 1,
+        InputFile file(inputFile);
+        Box2i dw = file.header().dataWindow();
+        unsigned int w = dw.max.x - dw.min.x + 1,
                      h = dw.max.y - dw.min.y + 1;
-        pixels.resizeErase(h, w);
-        file.setFrameBuffer(&pixels[0][0] - dw.min.x - dw.min.y*w, 1, w);
-        file.readPixels(dw.min.y, dw.max.y);
         
-        frame.width = w;
-        frame.height = h;
-        frame.channels = 3;
-        if (!frame.init())
+        // Locate the available color channels
+        const ChannelList &chl = file.header().channels();
+        const char *names[] = {"R", "G", "B"};
+        int src[3] = {-1, -1, -1};
+        for (int c=0; c<3; c++)
+            if (chl.findChannel(names[c]) != NULL)
+                src[c] = c;
+        
+        if (src[0] < 0 && src[1] < 0 && src[2] < 0)
+            throw LumaException("Reading of luminance only frames not yet supported");
+        
+        // Missing channels are replicated from an available one
+        int first = src[0] >= 0 ? 0 : (src[1] >= 0 ? 1 : 2);
+        for (int c=0; c<3; c++)
+            if (src[c] < 0)
+                src[c] = first;
+        
+        if (!frame.resize(w, h, 3))
             throw LumaException("Cannot allocate memory for input frame");
         
-        switch (file.channels())
+        FrameBuffer fb;
+        for (int c=0; c<3; c++)
         {
-            case WRITE_RGB:
-            case WRITE_RGBA:
-            {
-                for (size_t y=0; y<h; y++)
-                    for (size_t x=0; x<w; x++)
-                    {
-                        Rgba &p = pixels[y][x];
-                        frame.getChannel(0)[x+y*w] = p.r;
-                        frame.getChannel(1)[x+y*w] = p.g;
-                        frame.getChannel(2)[x+y*w] = p.b;
-                    }
-	        }
-	        break;
-	        case WRITE_R:
-	        {
-                for (size_t y=0; y<h; y++)
-                    for (size_t x=0; x<w; x++)
-                    {
-                        Rgba &p = pixels[y][x];
-                        frame.getChannel(0)[x+y*w] = p.r;
-                        frame.getChannel(1)[x+y*w] = p.r;
-                        frame.getChannel(2)[x+y*w] = p.r;
-                    }
-	        }
-	        break;
-	        case WRITE_G:
-	        {
-                for (size_t y=0; y<h; y++)
-                    for (size_t x=0; x<w; x++)
-                    {
-                        Rgba &p = pixels[y][x];
-                        frame.getChannel(0)[x+y*w] = p.g;
-                        frame.getChannel(1)[x+y*w] = p.g;
-                        frame.getChannel(2)[x+y*w] = p.g;
-                    }
-	        }
-	        break;
-	        case WRITE_B:
-	        {
-                for (size_t y=0; y<h; y++)
-                    for (size_t x=0; x<w; x++)
-                    {
-                        Rgba &p = pixels[y][x];
-                        frame.getChannel(0)[x+y*w] = p.b;
-                        frame.getChannel(1)[x+y*w] = p.b;
-                        frame.getChannel(2)[x+y*w] = p.b;
-                    }
-	        }
-	        break;
-	        default:
-	            throw LumaException("Reading of luminance only frames not yet supported");
-	            break;
-	    }
+            if (src[c] != c)
+                continue;
+            char *base = (char*)frame.getChannel(c)
+                         - (dw.min.x + (ptrdiff_t)dw.min.y*w)*(ptrdiff_t)sizeof(float);
+            fb.insert(names[c], Slice(FLOAT, base, sizeof(float), w*sizeof(float)));
+        }
+        
+        file.setFrameBuffer(fb);
+        file.readPixels(dw.min.y, dw.max.y);
+        
+        for (int c=0; c<3; c++)
+            if (src[c] != c)
+                memcpy(frame.getChannel(c), frame.getChannel(src[c]), w*h*sizeof(float));
     }
     catch (const std::exception &e)
     {
         throw LumaException(e.what());
     }
     
+    gettimeofday(&stop, NULL);
+    if (readTime != NULL)
+        *readTime = (stop.tv_sec-start.tv_sec)*1000.0f + (stop.tv_usec-start.tv_usec)/1000.0f;
+    
     return 1;
 }
 
 // Write an exr frame to file
-bool ExrInterface::writeFrame(const char *outputFile, LumaFrame &frame)
+//
+// The frame planes are passed to OpenEXR as float slices, and converted to 
+// the channel type of the file (half or float) while writing.
+bool ExrInterface::writeFrame(const char *outputFile, LumaFrame &frame,
+                              compression_t compression, bool half)
 {
+    LumaTraceScope trace("exr_write");
+    
     if (frame.buffer == NULL)
         throw LumaException("Frame does not contain any data");
     
     try
     {
         unsigned int w = frame.width, h = frame.height;
-        Array2D<Rgba> pixels;
-        pixels.resizeErase(h, w);
-        for (size_t y=0; y<h; y++)
-	        for (size_t x=0; x<w; x++)
-	        {
-	            Rgba &p = pixels[y][x];
-	            p.r = frame.getChannel(0)[x+y*w];
-	            p.g = frame.getChannel(1)[x+y*w];
-	            p.b = frame.getChannel(2)[x+y*w];
-	            p.a = 0;
-	        }
         
-        RgbaOutputFile file(outputFile, w, h, WRITE_RGB);
-        file.setFrameBuffer(&pixels[0][0], 1, w);
+        Compression comp;
+        switch (compression)
+        {
+        case EXR_NONE:
+            comp = NO_COMPRESSION;
+            break;
+        case EXR_PIZ:
+            comp = PIZ_COMPRESSION;
+            break;
+        case EXR_DWAA:
+            comp = DWAA_COMPRESSION;
+            break;
+        case EXR_ZIP:
+        default:
+            comp = ZIP_COMPRESSION;
+            break;
+        }
+        
+        Header header(w, h);
+        header.compression() = comp;
+        
+        const char *names[] = {"R", "G", "B"};
+        FrameBuffer fb;
+        for (int c=0; c<3; c++)
+        {
+            header.channels().insert(names[c], Channel(half ? HALF : FLOAT));
+            fb.insert(names[c], Slice(FLOAT, (char*)frame.getChannel(c), sizeof(float), w*sizeof(float)));
+        }
+        
+        OutputFile file(outputFile, header);
+        file.setFrameBuffer(fb);
         file.writePixels(h);
     }
     catch (const std::exception &e)
@@ -186,4 +217,9 @@ bool ExrInterface::writeFrame(const char *outputFile, LumaFrame &frame)
     return 1;
 }
 
+// Number of threads used by OpenEXR for (de)compression of scanline blocks
+void ExrInterface::setThreadCount(unsigned int threads)
+{
+    setGlobalThreadCount(threads);
+}
 
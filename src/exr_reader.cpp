@@ -0,0 +1,180 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#include "exr_reader.h"
+#include "luma_exception.h"
+
+#include <stdio.h>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+ExrReader::ExrReader(const char *pattern,
+                     unsigned int startFrame, unsigned int stepFrame, unsigned int endFrame,
+                     unsigned int threads, unsigned int prefetch) :
+    m_pattern(pattern), m_start(startFrame), m_step(std::max(stepFrame, 1u)), 
+    m_issued(0), m_consumed(0), m_prefetch(std::max(prefetch, 1u)), m_stop(false),
+    m_slots(m_prefetch)
+{
+    m_count = endFrame >= startFrame ? (endFrame - startFrame) / m_step + 1 : 0;
+    
+    // Announce the first frames to the file system
+    for (unsigned int i=0; i<2*m_prefetch && i<m_count; i++)
+        hint(i);
+    
+    for (unsigned int i=0; i<std::max(threads, 1u); i++)
+        m_threads.push_back(std::thread(&ExrReader::worker, this));
+}
+
+ExrReader::~ExrReader()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_slotAvailable.notify_all();
+    
+    for (size_t i=0; i<m_threads.size(); i++)
+        m_threads[i].join();
+}
+
+// Get the next frame of the sequence. The pixel data is handed over by 
+// swapping buffers with the frame. Returns false when the sequence has ended
+bool ExrReader::readFrame(LumaFrame &frame, float *readTime)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    
+    if (m_consumed >= m_count)
+        return false;
+    
+    Slot &slot = m_slots[m_consumed % m_prefetch];
+    while (slot.state != SLOT_READY && slot.state != SLOT_FAILED)
+        m_frameReady.wait(lock);
+    
+    if (slot.state == SLOT_FAILED)
+    {
+        // Stop reading beyond the failed frame
+        m_count = m_consumed;
+        m_slotAvailable.notify_all();
+        throw LumaException(slot.error.c_str());
+    }
+    
+    frame.swap(slot.frame);
+    if (readTime != NULL)
+        *readTime = slot.readTime;
+    
+    slot.state = SLOT_EMPTY;
+    m_consumed++;
+    
+    // Keep the file system busy with the frames after the prefetched ones
+    if (m_consumed + 2*m_prefetch - 1 < m_count)
+        hint(m_consumed + 2*m_prefetch - 1);
+    
+    lock.unlock();
+    m_slotAvailable.notify_all();
+    
+    return true;
+}
+
+// Number of frames read ahead, or being read
+unsigned int ExrReader::queueDepth()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_issued - m_consumed;
+}
+
+std::string ExrReader::fileName(unsigned int ind)
+{
+    char str[500];
+    snprintf(str, 499, m_pattern.c_str(), m_start + ind*m_step);
+    return std::string(str);
+}
+
+// Ask the operating system to start reading a file in the background
+void ExrReader::hint(unsigned int ind)
+{
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+    int fd = open(fileName(ind).c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        close(fd);
+    }
+#else
+    (void)ind;
+#endif
+}
+
+void ExrReader::worker()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (1)
+    {
+        while (!m_stop && !(m_issued < m_count && m_issued < m_consumed + m_prefetch))
+            m_slotAvailable.wait(lock);
+        if (m_stop)
+            break;
+        
+        unsigned int ind = m_issued++;
+        Slot &slot = m_slots[ind % m_prefetch];
+        slot.state = SLOT_READING;
+        lock.unlock();
+        
+        std::string error;
+        float readTime = 0.0f;
+        std::string file = fileName(ind);
+        try
+        {
+            ExrInterface::readFrame(file.c_str(), slot.frame, &readTime);
+        }
+        catch (std::exception &e)
+        {
+            error = e.what();
+        }
+        
+        lock.lock();
+        slot.readTime = readTime;
+        slot.error = error;
+        slot.state = error.empty() ? SLOT_READY : SLOT_FAILED;
+        m_frameReady.notify_all();
+    }
+}
+
@@ -0,0 +1,155 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#include "exr_writer.h"
+#include "luma_exception.h"
+
+#include <algorithm>
+
+ExrWriter::ExrWriter(unsigned int threads, unsigned int queueSize) :
+    m_pool(std::max(queueSize, 1u)), m_maxQueue(std::max(queueSize, 1u)), m_active(0), m_stop(false), m_half(true),
+    m_compression(ExrInterface::EXR_ZIP)
+{
+    for (unsigned int i=0; i<threads; i++)
+        m_threads.push_back(std::thread(&ExrWriter::worker, this));
+}
+
+ExrWriter::~ExrWriter()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_jobAvailable.notify_all();
+    
+    for (size_t i=0; i<m_threads.size(); i++)
+        m_threads[i].join();
+}
+
+// Queue a frame for writing. The pixel data is handed over to the writer by
+// swapping buffers, and the frame is left with a buffer of the same size
+void ExrWriter::writeFrame(const char *outputFile, LumaFrame &frame)
+{
+    if (frame.buffer == NULL)
+        throw LumaException("Frame does not contain any data");
+    
+    // Without worker threads the frame is written directly
+    if (m_threads.empty())
+    {
+        ExrInterface::writeFrame(outputFile, frame, m_compression, m_half);
+        return;
+    }
+    
+    std::unique_lock<std::mutex> lock(m_mutex);
+    
+    // Wait for a free slot, to bound the number of frames in memory
+    while (m_error.empty() && m_queue.size() + m_active >= m_maxQueue)
+        m_slotAvailable.wait(lock);
+    rethrow();
+    
+    Job job;
+    job.file = outputFile;
+    job.frame = m_pool.acquire(frame.width, frame.height, frame.channels);
+    job.frame.swap(frame);
+    
+    m_queue.push_back(std::move(job));
+    lock.unlock();
+    m_jobAvailable.notify_one();
+}
+
+// Wait for all queued frames to be written
+void ExrWriter::finish()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_error.empty() && (!m_queue.empty() || m_active > 0))
+        m_slotAvailable.wait(lock);
+    rethrow();
+}
+
+// Number of frames waiting to be written, or being written
+unsigned int ExrWriter::queueDepth()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_queue.size() + m_active;
+}
+
+// Report errors from the worker threads in the calling thread (mutex is held)
+void ExrWriter::rethrow()
+{
+    if (!m_error.empty())
+    {
+        std::string msg = m_error;
+        m_error.clear();
+        throw LumaException(msg.c_str());
+    }
+}
+
+void ExrWriter::worker()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (1)
+    {
+        while (!m_stop && m_queue.empty())
+            m_jobAvailable.wait(lock);
+        if (m_queue.empty())
+            break;
+        
+        Job job = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_active++;
+        lock.unlock();
+        
+        std::string error;
+        try
+        {
+            ExrInterface::writeFrame(job.file.c_str(), job.frame, m_compression, m_half);
+        }
+        catch (std::exception &e)
+        {
+            error = "Failed to write '" + job.file + "': " + e.what();
+        }
+        
+        lock.lock();
+        m_active--;
+        m_pool.release(std::move(job.frame));
+        if (!error.empty() && m_error.empty())
+            m_error = error;
+        m_slotAvailable.notify_all();
+    }
+}
+
@@ -37,6 +37,7 @@
  */
 
 #include "luma_decoder.h"
+#include "luma_meta_data.h"
 #include "luma_exception.h"
 
 #include <cstdio>
@@ -69,69 +70,57 @@ bool LumaDecoder::initialize(const char *inputFile, bool verbose)
     
     // Open Matroska file
     m_reader.openRead(inputFile);
-    m_reader.setVerbose(verbose);
     
-    // Read attachments
-    binary *buffer;
-    unsigned int ind = 0, id, buffer_size, mapping_size;
-    float *mapping;
-    bool ptfBDFound = 0, colorBDFound = 0, ptfFound = 0, csFound = 0, mappingFound = 0;
-    while (m_reader.getAttachment(ind++, &buffer, id, buffer_size))
-    {
-        switch (id)
-        {
-        case 430:
-            m_params.ptfBitDepth = *((unsigned int*)buffer);
-            ptfBDFound = 1;
-            break;
-        case 431:
-            m_params.colorBitDepth = *((unsigned int*)buffer);
-            colorBDFound = 1;
-            break;
-        case 432:
-            m_params.ptf = *((LumaQuantizer::ptf_t*)buffer);
-            ptfFound = 1;
-            break;
-        case 433:
-            m_params.colorSpace = *((LumaQuantizer::colorSpace_t*)buffer);
-            csFound = 1;
-            break;
-        case 434:
-            mapping = (float*)buffer;
-            mapping_size = buffer_size;
-            mappingFound = 1;
-            break;
-        case 435:
-            m_params.preScaling = *((float*)buffer);
-            break;
-        case 436:
-            m_params.maxLum = ((float*)buffer)[0];
-            m_params.minLum = ((float*)buffer)[1];
-            break;
-        }
-    }
+    return initializeCodec(inputFile, verbose);
+}
+
+// Initialize decoder, for reading from memory (see luma_io.h)
+bool LumaDecoder::initialize(IOCallback *input, bool verbose)
+{
+    if (input == NULL)
+        return false;
+    
+    m_reader.openRead(input);
     
-    if (!(ptfBDFound && colorBDFound && ptfFound && csFound && mappingFound))
+    return initializeCodec("<memory>", verbose);
+}
+
+// Read meta data and set up the VP9 codec, once the input has been opened
+bool LumaDecoder::initializeCodec(const char *inputName, bool verbose)
+{
+    m_reader.setVerbose(verbose);
+    
+    // Read meta data
+    LumaMetaData meta;
+    if (!meta.readAttachments(m_reader))
     {
-        std::string msg = "Failed to locate Luma HDRv meta data in '" + std::string(inputFile) + "'";
+        std::string msg = "Failed to locate Luma HDRv meta data in '" + std::string(inputName) + "'";
         throw LumaException(msg.c_str());
     }
+    m_params.ptf = meta.ptf;
+    m_params.colorSpace = meta.colorSpace;
+    m_params.ptfBitDepth = meta.ptfBitDepth;
+    m_params.colorBitDepth = meta.colorBitDepth;
+    m_params.preScaling = meta.preScaling;
+    m_params.maxLum = meta.maxLum;
+    m_params.minLum = meta.minLum;
     
     // Initialize quantizer
     m_quant.setQuantizer(m_params.ptf, m_params.ptfBitDepth, m_params.colorSpace, m_params.colorBitDepth, m_params.maxLum, m_params.minLum);
-    memcpy((void*)m_quant.getMapping(), (void*)mapping, mapping_size);
+    if (!meta.mapping.empty())
+        m_quant.setMapping(meta.mapping.data(), meta.mapping.size());
     
     // Initialize VPX codec
     const vpx_codec_iface_t *(*const vpx_decoder)() = &vpx_codec_vp9_dx;
 
     fprintf(stderr, "\nDecoding options:\n");
     fprintf(stderr, "-------------------------------------------------------------------\n");
-    fprintf(stderr, "Transfer function (PTF):   %s\n", ptfFound ? m_quant.name(m_params.ptf).c_str() : "--");
+    fprintf(stderr, "Transfer function (PTF):   %s\n", m_quant.name(m_params.ptf).c_str());
     if (m_params.ptf == LumaQuantizer::PTF_PQ || m_params.ptf == LumaQuantizer::PTF_LOG || m_params.ptf == LumaQuantizer::PTF_LINEAR)
         fprintf(stderr, "Encoding luminance range:  %.4f-%.2f\n", m_quant.getMinLum(), m_quant.getMaxLum());
-    fprintf(stderr, "Color space:               %s\n", csFound ? m_quant.name(m_params.colorSpace).c_str() : "--");
-    fprintf(stderr, "PTF bit depth:             %d\n", ptfBDFound ? m_params.ptfBitDepth : -1);
-    fprintf(stderr, "Color bit depth:           %d\n", colorBDFound ? m_params.colorBitDepth : -1);
+    fprintf(stderr, "Color space:               %s\n", m_quant.name(m_params.colorSpace).c_str());
+    fprintf(stderr, "PTF bit depth:             %d\n", m_params.ptfBitDepth);
+    fprintf(stderr, "Color bit depth:           %d\n", m_params.colorBitDepth);
     fprintf(stderr, "Codec:                     %s\n", vpx_codec_iface_name(vpx_decoder()));
     fprintf(stderr, "-------------------------------------------------------------------\n\n");
 
@@ -151,16 +140,7 @@ bool LumaDecoder::initialize(const char *inputFile, bool verbose)
     
     m_firstFrame = true;
     
-    m_params.highBitDepth = m_vpxFrame->fmt & VPX_IMG_FMT_HIGHBITDEPTH;
-    const int m = (m_params.highBitDepth ? 2 : 1);    
-    m_params.stride = m_vpxFrame->stride;
-    m_params.profile = m_vpxFrame->x_chroma_shift ? 2*m-2 : 2*m-1;
-    m_params.width[0] = m_vpxFrame->d_w;
-    m_params.width[1] = m_vpxFrame->x_chroma_shift > 0 ? (m_vpxFrame->d_w + 1) >> m_vpxFrame->x_chroma_shift : m_vpxFrame->d_w;
-    m_params.width[2] = m_vpxFrame->x_chroma_shift > 0 ? (m_vpxFrame->d_w + 1) >> m_vpxFrame->x_chroma_shift : m_vpxFrame->d_w;
-    m_params.height[0] = m_vpxFrame->d_h;
-    m_params.height[1] = m_vpxFrame->y_chroma_shift > 0 ? (m_vpxFrame->d_h + 1) >> m_vpxFrame->y_chroma_shift : m_vpxFrame->d_h;
-    m_params.height[2] = m_vpxFrame->y_chroma_shift > 0 ? (m_vpxFrame->d_h + 1) >> m_vpxFrame->y_chroma_shift : m_vpxFrame->d_h;
+    updateGeometry();
     
     return true;
 }
@@ -177,39 +157,75 @@ bool LumaDecoder::run()
         return true;
     }
     
-    //timeval start, stop;
-    //gettimeofday(&start, NULL);
-    
     m_vpxFrame = NULL;
     vpx_codec_iter_t iter = NULL;
     
-    if (!m_reader.readFrame()) // Reading frame failed, probably EOF
-        return false;
-
+    uint64_t start = lumaTimeNs();
     unsigned int frame_size = 0;
-    const uint8_t *frame = m_reader.getFrame(frame_size);
+    const uint8_t *frame = NULL;
+    {
+        LumaTraceScope trace("read_frame");
+        if (!m_reader.readFrame()) // Reading frame failed, probably EOF
+            return false;
+        frame = m_reader.getFrame(frame_size);
+    }
     
-    if (vpx_codec_decode(&m_codec, frame, frame_size, NULL, 0))
-        throw LumaException("Failed to decode frame");
+    uint64_t demuxed = lumaTimeNs();
+    m_stats.addTime(LumaStats::STAGE_MUX, demuxed - start);
     
-    if ((m_vpxFrame = vpx_codec_get_frame(&m_codec, &iter)) == NULL)
-        throw("Failed to get decoded frame");
+    {
+        LumaTraceScope trace("vpx_codec_decode");
+        if (vpx_codec_decode(&m_codec, frame, frame_size, NULL, 0))
+            throw LumaException("Failed to decode frame");
+        
+        if ((m_vpxFrame = vpx_codec_get_frame(&m_codec, &iter)) == NULL)
+            throw LumaException("Failed to get decoded frame");
+    }
+    
+    m_stats.addTime(LumaStats::STAGE_CODEC, lumaTimeNs() - demuxed);
     
-    //gettimeofday(&stop, NULL);
-    //fprintf(stderr, "DECODING TIME: %f\n", (stop.tv_usec-start.tv_usec)/1000.0f);
+    vpx_codec_stream_info_t si;
+    si.sz = sizeof(si);
+    si.is_kf = 0;
+    vpx_codec_peek_stream_info(vpx_codec_vp9_dx(), frame, frame_size, &si);
+    m_stats.addPacket(frame_size, si.is_kf);
 	
 	return true;
 }
 
 
+// Format and plane sizes of the last decoded VPX image, which can change
+// between frames of a stream
+void LumaDecoder::updateGeometry()
+{
+    m_params.highBitDepth = m_vpxFrame->fmt & VPX_IMG_FMT_HIGHBITDEPTH;
+    const int m = (m_params.highBitDepth ? 2 : 1);    
+    m_params.stride = m_vpxFrame->stride;
+    m_params.profile = m_vpxFrame->x_chroma_shift ? 2*m-2 : 2*m-1;
+    m_params.width[0] = m_vpxFrame->d_w;
+    m_params.width[1] = m_vpxFrame->x_chroma_shift > 0 ? (m_vpxFrame->d_w + 1) >> m_vpxFrame->x_chroma_shift : m_vpxFrame->d_w;
+    m_params.width[2] = m_vpxFrame->x_chroma_shift > 0 ? (m_vpxFrame->d_w + 1) >> m_vpxFrame->x_chroma_shift : m_vpxFrame->d_w;
+    m_params.height[0] = m_vpxFrame->d_h;
+    m_params.height[1] = m_vpxFrame->y_chroma_shift > 0 ? (m_vpxFrame->d_h + 1) >> m_vpxFrame->y_chroma_shift : m_vpxFrame->d_h;
+    m_params.height[2] = m_vpxFrame->y_chroma_shift > 0 ? (m_vpxFrame->d_h + 1) >> m_vpxFrame->y_chroma_shift : m_vpxFrame->d_h;
+}
+
+// Dequantize the decoded VPX image in to the frame buffer
 void LumaDecoder::getVpxChannels()
 {
+    updateGeometry();
+    
+    // The buffer is only reallocated if the frame size changes
+    if (!m_frame.resize(m_vpxFrame->d_w, m_vpxFrame->d_h, 3))
+        throw LumaException("Cannot allocate memory for decoded frame");
+    
     for (unsigned int plane=0; plane<3; plane++)
     {
         float *dest = m_frame.getChannel(plane);
         unsigned char *buf = m_vpxFrame->planes[plane];
         //unsigned short *bufS = (unsigned short*)(m_vpxFrame->planes[plane]);
         const int w = m_params.width[plane], h = m_params.height[plane], stride = m_params.stride[plane], profile = m_params.profile;
+        const int W = m_params.width[0], H = m_params.height[0];
         
         //fprintf(stderr, "--plane %d: %dx%d. stride = %d, bit depth = %d, profile = %d\n", plane, w, h, stride, profile>1?16:8, profile);
         
@@ -228,9 +244,12 @@ void LumaDecoder::getVpxChannels()
                 
                 if (plane && (profile == 2 || profile == 0))
                 {
-                    ind1 = 2*x+4*y*w;
-                    ind2 = ind1 + 2*w;
-                    dest[ind1] = dest[ind1+1] = dest[ind2] = dest[ind2+1] = val;
+                    // Chroma is upsampled to the luma size, which can be odd
+                    ind1 = 2*x+2*y*W;
+                    ind2 = 2*y+1 < H ? ind1 + W : ind1;
+                    dest[ind1] = dest[ind2] = val;
+                    if (2*x+1 < W)
+                        dest[ind1+1] = dest[ind2+1] = val;
                 }
                 else
                     dest[x+y*w] = val;
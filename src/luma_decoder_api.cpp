@@ -0,0 +1,237 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#define LUMA_API_BUILD
+#include "luma_api.h"
+#include "luma_image.h"
+#include "luma_decoder.h"
+#include "luma_io.h"
+#include "luma_exception.h"
+
+#include <string>
+#include <memory>
+#include <new>
+
+struct luma_decoder
+{
+    LumaDecoder decoder;
+    std::unique_ptr<LumaMemoryReader> input;
+};
+
+static thread_local std::string s_error;
+
+// Write the planar channels of a decoded frame to a frame of the caller.
+// Channels after the first three are set to 1
+static void writeImage(const LumaFrame &frame, const luma_image_t &image)
+{
+    const LumaImageView view = lumaImageView(image);
+    const size_t stride = view.pixelBytes(), bytes = view.sampleBytes();
+    const unsigned int w = image.width, h = image.height;
+    const float one = 1.0f;
+    const uint16_t oneHalf = 0x3c00;
+    
+    for (unsigned int c = 0; c < image.channels; c++)
+        for (unsigned int y = 0; y < h; y++)
+        {
+            char *dst = (char*)view.sample(c, 0, y);
+            const float *src = c < 3 ? frame.getChannel(c) + (size_t)y*w : NULL;
+            
+            if (src == NULL)
+                for (unsigned int x = 0; x < w; x++)
+                    memcpy(dst + x*stride, image.type == LUMA_FLOAT32 ? (const void*)&one : (const void*)&oneHalf, bytes);
+            else if (image.type == LUMA_FLOAT32 && stride == sizeof(float))
+                memcpy(dst, src, w*sizeof(float));
+            else if (image.type == LUMA_FLOAT32)
+                for (unsigned int x = 0; x < w; x++)
+                    memcpy(dst + x*stride, src + x, sizeof(float));
+            else
+                for (unsigned int x = 0; x < w; x++)
+                {
+                    uint16_t v = lumaFloatToHalf(src[x]);
+                    memcpy(dst + x*stride, &v, sizeof(uint16_t));
+                }
+        }
+}
+
+static int setError(const char *msg, int status = LUMA_ERROR)
+{
+    s_error = msg;
+    return status;
+}
+
+int luma_dec_api_version(void)
+{
+    return LUMA_API_VERSION;
+}
+
+static luma_decoder_t *create(const char *inputFile, const void *data, size_t size)
+{
+    luma_decoder_t *dec = NULL;
+    try
+    {
+        dec = new luma_decoder_t;
+        
+        bool res;
+        if (data != NULL)
+        {
+            dec->input.reset(new LumaMemoryReader(data, size));
+            res = dec->decoder.initialize(dec->input.get());
+        }
+        else
+            res = dec->decoder.initialize(inputFile);
+        
+        if (!res)
+            throw LumaException("No frames in input");
+        
+        return dec;
+    }
+    catch (std::exception &e)
+    {
+        setError(e.what());
+    }
+    catch (...)
+    {
+        setError("Unknown error");
+    }
+    
+    delete dec;
+    return NULL;
+}
+
+luma_decoder_t *luma_dec_create(const char *input_file)
+{
+    if (input_file == NULL)
+    {
+        setError("No input file");
+        return NULL;
+    }
+    
+    return create(input_file, NULL, 0);
+}
+
+luma_decoder_t *luma_dec_create_memory(const void *data, size_t size)
+{
+    if (data == NULL || !size)
+    {
+        setError("No input data");
+        return NULL;
+    }
+    
+    return create(NULL, data, size);
+}
+
+int luma_dec_get_info(luma_decoder_t *dec, unsigned int *width, unsigned int *height, float *fps)
+{
+    if (dec == NULL)
+        return setError("No decoder", LUMA_INVALID_ARGUMENT);
+    
+    LumaDecoderParams params = dec->decoder.getParams();
+    if (width != NULL)
+        *width = params.width[0];
+    if (height != NULL)
+        *height = params.height[0];
+    if (fps != NULL)
+    {
+        int duration = dec->decoder.getReader()->getFrameDuration();
+        *fps = duration > 0 ? 1000.0f / duration : 0.0f;
+    }
+    
+    return LUMA_OK;
+}
+
+int luma_dec_next_frame(luma_decoder_t *dec, const luma_image_t *frame)
+{
+    if (dec == NULL)
+        return setError("No decoder", LUMA_INVALID_ARGUMENT);
+    
+    LumaDecoderParams params = dec->decoder.getParams();
+    const char *err = lumaImageError(frame, params.width[0], params.height[0]);
+    if (err != NULL)
+        return setError(err, LUMA_INVALID_ARGUMENT);
+    
+    try
+    {
+        // The decoded frame is owned by the decoder, until the next call
+        LumaFrame *decoded = dec->decoder.decode();
+        if (decoded == NULL)
+            return LUMA_END_OF_STREAM;
+        
+        writeImage(*decoded, *frame);
+    }
+    catch (std::exception &e)
+    {
+        return setError(e.what());
+    }
+    catch (...)
+    {
+        return setError("Unknown error");
+    }
+    
+    return LUMA_OK;
+}
+
+int luma_dec_seek(luma_decoder_t *dec, float seconds)
+{
+    if (dec == NULL)
+        return setError("No decoder", LUMA_INVALID_ARGUMENT);
+    
+    try
+    {
+        dec->decoder.seekToTime(1000.0f*seconds, true);
+    }
+    catch (std::exception &e)
+    {
+        return setError(e.what());
+    }
+    catch (...)
+    {
+        return setError("Unknown error");
+    }
+    
+    return LUMA_OK;
+}
+
+void luma_dec_destroy(luma_decoder_t *dec)
+{
+    delete dec;
+}
+
+const char *luma_dec_last_error(void)
+{
+    return s_error.c_str();
+}
@@ -37,6 +37,7 @@
  */
 
 #include "luma_encoder.h"
+#include "luma_meta_data.h"
 #include "luma_exception.h"
 
 #include <math.h>
@@ -45,6 +46,9 @@
 LumaEncoder::LumaEncoder()
 {
 	m_frameCount = 0;
+    m_rawBuffer = NULL;
+    m_rawBytes = 0;
+    m_rawMapped = false;
 
     m_initialized = false;
 }
@@ -54,6 +58,7 @@ LumaEncoder::~LumaEncoder()
     if (m_initialized)
     {
         vpx_img_free(&m_rawFrame);
+        lumaFree(m_rawBuffer, m_rawBytes, m_rawMapped);
         if (vpx_codec_destroy(&m_codec))
 	        fprintf(stderr, "Failed to destroy codec.\n");
 	}
@@ -65,6 +70,20 @@ bool LumaEncoder::initialize(const char *outputFile, const unsigned int w, const
     // Initialize base. Creates a Matroska file for writing
     LumaEncoderBase::initialize(outputFile, w, h, m_params.maxLum, m_params.minLum);
     
+    return initializeCodec(outputFile, w, h, verbose);
+}
+
+// Initialize encoder, for writing to memory or a user callback (see luma_io.h)
+bool LumaEncoder::initialize(IOCallback *output, const unsigned int w, const unsigned int h, bool seekable, bool verbose)
+{
+    LumaEncoderBase::initialize(output, w, h, m_params.maxLum, m_params.minLum, seekable);
+    
+    return initializeCodec("<memory>", w, h, verbose);
+}
+
+// Write meta data and set up the VP9 codec, once the output has been opened
+bool LumaEncoder::initializeCodec(const char *outputName, const unsigned int w, const unsigned int h, bool verbose)
+{
     // Adjust profile for the specified bit depth (0-1 for 8 bits, and 2-3 for higher bit depths)
     if (m_params.profile > 1 && m_params.bitDepth == 8)
         m_params.profile -=2;
@@ -74,39 +93,26 @@ bool LumaEncoder::initialize(const char *outputFile, const unsigned int w, const
     // Initialize quantizer
     m_quant.setQuantizer(m_params.ptf, m_params.ptfBitDepth, m_params.colorSpace, m_params.colorBitDepth, m_params.maxLum, m_params.minLum);
     
-    // Add attachments with meta data to Matroska file
-    unsigned int *buffer1 = new unsigned int;
-    *buffer1 = m_params.ptfBitDepth;
-    m_writer.addAttachment(430, (const binary*)buffer1, sizeof(unsigned int), "PTF bit depth");
-    
-    unsigned int *buffer2 = new unsigned int;
-    *buffer2 = m_params.colorBitDepth;
-    m_writer.addAttachment(431, (const binary*)buffer2, sizeof(unsigned int), "Color bit depth");
-    
-    LumaQuantizer::ptf_t *buffer3 = new LumaQuantizer::ptf_t;
-    *buffer3 = m_params.ptf;
-    m_writer.addAttachment(432, (const binary*)buffer3, sizeof(LumaQuantizer::ptf_t), "PTF description");
-    
-    LumaQuantizer::colorSpace_t *buffer4 = new LumaQuantizer::colorSpace_t;
-    *buffer4 = m_params.colorSpace;
-    m_writer.addAttachment(433, (const binary*)buffer4, sizeof(LumaQuantizer::colorSpace_t), "Color space");
-    
-    float *buffer5 = new float[m_quant.getSize()];
-    memcpy((void*)buffer5, (void*)m_quant.getMapping(), (m_quant.getSize())*sizeof(float));
-    m_writer.addAttachment(434, (const binary*)buffer5, (m_quant.getSize())*sizeof(float), "PTF");
+    // Add meta data to Matroska file, as one attachment
+    LumaMetaData meta;
+    meta.ptf = m_params.ptf;
+    meta.colorSpace = m_params.colorSpace;
+    meta.ptfBitDepth = m_params.ptfBitDepth;
+    meta.colorBitDepth = m_params.colorBitDepth;
+    meta.preScaling = m_params.preScaling;
+    meta.maxLum = m_params.maxLum;
+    meta.minLum = m_params.minLum;
     
-    float *buffer6 = new float;
-    *buffer6 = m_params.preScaling;
-    m_writer.addAttachment(435, (const binary*)buffer6, sizeof(float), "Scaling");
-
-    float *buffer7 = new float[2];
-    buffer7[0] = m_params.maxLum; buffer7[1] = m_params.minLum;
-    m_writer.addAttachment(436, (const binary*)buffer7, 2*sizeof(float), "Luminance range");
+    // Analytic PTFs are regenerated from the parameters when decoding
+    if (LumaQuantizer::tabulated(m_params.ptf))
+        meta.mapping.assign(m_quant.getMapping(), m_quant.getMapping() + m_quant.getSize() + 1);
+    meta.addAttachment(m_writer);
     
     m_writer.writeAttachments();
     
     // Framerate for timecodes    
     m_writer.setFramerate(m_params.fps);
+    m_writer.setClusterLimits((size_t)m_params.maxClusterSize << 10, m_params.maxClusterDuration);
     
     m_writer.setVerbose(verbose);
     
@@ -118,20 +124,37 @@ bool LumaEncoder::initialize(const char *outputFile, const unsigned int w, const
     if (w <= 0 || h <= 0 || (w % 2) != 0 || (h % 2) != 0)
         throw LumaException("Invalid frame size");
 
-    if (m_params.profile == 0 && !vpx_img_alloc(&m_rawFrame, VPX_IMG_FMT_I420, w, h, 32))
-	    throw LumaException("Failed to allocate 8 bit 420 image");
-    else if (m_params.profile == 1 && !vpx_img_alloc(&m_rawFrame, VPX_IMG_FMT_I444, w, h, 32))
-	    throw LumaException("Failed to allocate 8 bit 444 image");
-    else if (m_params.profile == 2 && !vpx_img_alloc(&m_rawFrame, VPX_IMG_FMT_I42016, w, h, 32))
-	    throw LumaException("Failed to allocate 16 bit 420 image");
-    else if (m_params.profile == 3 && !vpx_img_alloc(&m_rawFrame, VPX_IMG_FMT_I44416, w, h, 32))
-	    throw LumaException("Failed to allocate 16 bit 444 image");
+    // Raw image buffer, allocated according to the default allocation policy
+    vpx_img_fmt_t fmt = VPX_IMG_FMT_I420;
+    unsigned int bps = 12, cs = 1; // bits per pixel and chroma subsampling
+    if (m_params.profile == 1)
+    {
+        fmt = VPX_IMG_FMT_I444;
+        bps = 24; cs = 0;
+    }
+    else if (m_params.profile == 2)
+    {
+        fmt = VPX_IMG_FMT_I42016;
+        bps = 24;
+    }
+    else if (m_params.profile == 3)
+    {
+        fmt = VPX_IMG_FMT_I44416;
+        bps = 48; cs = 0;
+    }
+    
+    // Same layout as computed by vpx_img_alloc, with 32 byte stride alignment
+    size_t stride = (((w + cs) & ~cs) + 31) & ~31;
+    m_rawBytes = ((h + cs) & ~cs) * stride * bps / 8;
+    m_rawBuffer = (unsigned char*)lumaAlloc(m_rawBytes, m_rawMapped);
+    if (m_rawBuffer == NULL || !vpx_img_wrap(&m_rawFrame, fmt, w, h, 32, m_rawBuffer))
+        throw LumaException("Failed to allocate raw image");
 
     res = vpx_codec_enc_config_default(vpx_encoder(), &cfg, 0);
     if (res)
 	    throw LumaException("Failed to get default codec config");
 
-    cfg.g_threads = 6;
+    cfg.g_threads = std::max(m_params.threads, 1u);
     cfg.rc_min_quantizer = m_params.quantizerScale;
     cfg.rc_max_quantizer = m_params.quantizerScale;
     cfg.g_w = w;
@@ -144,7 +167,7 @@ bool LumaEncoder::initialize(const char *outputFile, const unsigned int w, const
     cfg.rc_end_usage = VPX_VBR;
     cfg.g_lag_in_frames = 0;
     cfg.rc_end_usage = VPX_Q;
-    cfg.kf_max_dist = 25;
+    cfg.kf_max_dist = m_params.keyframeInterval > 0 ? m_params.keyframeInterval : std::max(m_params.maxKeyframeInterval, 1u);
     cfg.kf_mode = VPX_KF_AUTO;
     cfg.g_profile = m_params.profile;
     
@@ -173,8 +196,14 @@ bool LumaEncoder::initialize(const char *outputFile, const unsigned int w, const
         cfg.g_bit_depth = VPX_BITS_12;
         fprintf(stderr, "12\n");
     }
+    if (m_params.keyframeInterval > 0)
+        fprintf(stderr, "Keyframes:                 every %d frames\n", m_params.keyframeInterval);
+    else if (m_params.sceneCutThreshold > 0.0f)
+        fprintf(stderr, "Keyframes:                 at scene cuts, at most %d frames apart\n", cfg.kf_max_dist);
+    else
+        fprintf(stderr, "Keyframes:                 at most %d frames apart\n", cfg.kf_max_dist);
     fprintf(stderr, "Codec:                     %s\n", vpx_codec_iface_name(vpx_encoder()));
-    fprintf(stderr, "Output:                    %s\n", outputFile);
+    fprintf(stderr, "Output:                    %s\n", outputName);
     fprintf(stderr, "-------------------------------------------------------------------\n\n");
 
     int flags = m_params.profile < 2 ? 0 : VPX_CODEC_USE_HIGHBITDEPTH;
@@ -188,6 +217,8 @@ bool LumaEncoder::initialize(const char *outputFile, const unsigned int w, const
 	if (m_params.lossLess && vpx_codec_control(&m_codec, VP9E_SET_LOSSLESS, 1))
 	    throw LumaException("Failed to use lossless mode\n");
 	
+	m_sceneCuts.setThreshold(m_params.sceneCutThreshold);
+	
     m_initialized = true;
     return true;
 }
@@ -205,9 +236,19 @@ bool LumaEncoder::run()
 {
 	int flags = 0;
 	
-	// Force key frame?
-	if (m_params.keyframeInterval > 0 && m_frameCount % m_params.keyframeInterval == 0)
-		flags = VPX_EFLAG_FORCE_KF;
+	// Force key frame, at the fixed interval or at a scene cut. The codec
+	// places keyframes at the maximum interval
+	if (m_params.keyframeInterval > 0)
+	{
+	    if (m_frameCount % m_params.keyframeInterval == 0)
+		    flags = VPX_EFLAG_FORCE_KF;
+	}
+	else if (m_params.sceneCutThreshold > 0.0f)
+	{
+	    LumaTraceScope trace("scene_cut");
+	    if (m_sceneCuts.detect(&m_rawFrame, m_quant.getSize()))
+	        flags = VPX_EFLAG_FORCE_KF;
+	}
     
     // Start encoder
 	encode_frame_vpx(&m_codec, &m_rawFrame, m_frameCount++, flags);
@@ -234,8 +275,12 @@ int LumaEncoder::encode_frame_vpx(vpx_codec_ctx_t *codec,
     int got_pkts = 0;
     vpx_codec_iter_t iter = NULL;
     const vpx_codec_cx_pkt_t *pkt = NULL;
+    uint64_t start = lumaTimeNs();
+    LumaTrace::begin("vpx_codec_encode");
     const vpx_codec_err_t res = vpx_codec_encode(codec, img, frame_index, 1,
                                                  flags, VPX_DL_GOOD_QUALITY); // VPX_DL_GOOD_QUALITY/VPX_DL_REALTIME
+    LumaTrace::end("vpx_codec_encode");
+    m_stats.addTime(LumaStats::STAGE_CODEC, lumaTimeNs() - start);
     if (res != VPX_CODEC_OK)
         fprintf(stderr, "Failed to encode frame\n");
 
@@ -247,7 +292,10 @@ int LumaEncoder::encode_frame_vpx(vpx_codec_ctx_t *codec,
         {
             const int keyframe = (pkt->data.frame.flags & VPX_FRAME_IS_KEY) != 0;
             
+            LumaTraceScope trace("add_frame");
+            LumaStageTimer timer(m_stats, LumaStats::STAGE_MUX);
             m_writer.addFrame((const uint8_t*)pkt->data.frame.buf, pkt->data.frame.sz, keyframe);
+            m_stats.addPacket(pkt->data.frame.sz, keyframe);
             //fprintf(stderr, keyframe ? "K" : ".");
             fflush(stdout);
         }
@@ -316,3 +364,65 @@ void LumaEncoder::setVpxChannel(vpx_image_t *dest, const float *src, int plane)
         fprintf(stderr, "\n\tWarning! Mean luminance is %f cd/m2. Is input calibrated to physical units? \n", avg);
 }
 
+// Downsampled copy of the luma plane, normalized to 0-1
+template <typename T>
+void LumaSceneCutDetector::downsample(const vpx_image_t *img, unsigned int maxValue)
+{
+    const unsigned int w = img->d_w, h = img->d_h, bw = (w + 7)/8, bh = (h + 7)/8;
+    const float scale = 1.0f / std::max(maxValue, 1u);
+    
+    m_current.resize((size_t)bw*bh);
+    m_rowSums.resize(bw);
+    
+    for (unsigned int by = 0; by < bh; by++)
+    {
+        const unsigned int y0 = 8*by, y1 = std::min(y0 + 8, h);
+        std::fill(m_rowSums.begin(), m_rowSums.end(), 0.0f);
+        
+        for (unsigned int y = y0; y < y1; y++)
+        {
+            const T *row = (const T*)(img->planes[0] + (size_t)y*img->stride[0]);
+            for (unsigned int x = 0; x < w; x++)
+                m_rowSums[x/8] += row[x];
+        }
+        
+        for (unsigned int bx = 0; bx < bw; bx++)
+        {
+            const unsigned int n = (std::min(8*bx + 8, w) - 8*bx) * (y1 - y0);
+            m_current[(size_t)by*bw + bx] = scale * m_rowSums[bx] / n;
+        }
+    }
+}
+
+bool LumaSceneCutDetector::detect(const vpx_image_t *img, unsigned int maxValue)
+{
+    const unsigned int bins = 32;
+    
+    if (img->fmt & VPX_IMG_FMT_HIGHBITDEPTH)
+        downsample<uint16_t>(img, maxValue);
+    else
+        downsample<uint8_t>(img, maxValue);
+    
+    bool cut = false;
+    const size_t n = m_current.size();
+    if (m_previous.size() == n && n)
+    {
+        unsigned int hist[bins] = {0}, histPrev[bins] = {0};
+        double diff = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            hist[std::min((unsigned int)(bins*m_current[i]), bins-1)]++;
+            histPrev[std::min((unsigned int)(bins*m_previous[i]), bins-1)]++;
+            diff += fabs(m_current[i] - m_previous[i]);
+        }
+        
+        unsigned int moved = 0;
+        for (unsigned int b = 0; b < bins; b++)
+            moved += hist[b] > histPrev[b] ? hist[b] - histPrev[b] : 0;
+        
+        cut = moved > m_threshold*n && diff > 0.05*n;
+    }
+    
+    m_previous.swap(m_current);
+    return cut;
+}
@@ -0,0 +1,281 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#define LUMA_API_BUILD
+#include "luma_api.h"
+#include "luma_image.h"
+#include "luma_encoder.h"
+#include "luma_io.h"
+#include "luma_exception.h"
+
+#include <string>
+#include <memory>
+#include <new>
+
+static_assert((int)LUMA_PTF_LINEAR == (int)LumaQuantizer::PTF_LINEAR, "PTF enums differ");
+static_assert((int)LUMA_CS_XYZ == (int)LumaQuantizer::CS_XYZ, "Color space enums differ");
+
+struct luma_encoder
+{
+    luma_encoder() : width(0), height(0), finished(false)
+    {}
+    
+    // The output is declared first, so that it outlives the encoder writing to it
+    std::unique_ptr<LumaCallbackWriter> output;
+    LumaEncoder encoder;
+    unsigned int width, height;
+    bool finished;
+};
+
+static thread_local std::string s_error;
+
+static int setError(const char *msg, int status = LUMA_ERROR)
+{
+    s_error = msg;
+    return status;
+}
+
+int luma_enc_api_version(void)
+{
+    return LUMA_API_VERSION;
+}
+
+void luma_enc_params_init(luma_enc_params_t *params)
+{
+    if (params == NULL)
+        return;
+    
+    LumaEncoderParams p;
+    params->struct_size = sizeof(luma_enc_params_t);
+    params->ptf = (luma_ptf_t)p.ptf;
+    params->color_space = (luma_color_space_t)p.colorSpace;
+    params->ptf_bit_depth = p.ptfBitDepth;
+    params->color_bit_depth = p.colorBitDepth;
+    params->bit_depth = p.bitDepth;
+    params->profile = p.profile;
+    params->quantizer_scale = p.quantizerScale;
+    params->bitrate = p.bitrate;
+    params->keyframe_interval = p.keyframeInterval;
+    params->pre_scaling = p.preScaling;
+    params->min_lum = p.minLum;
+    params->max_lum = p.maxLum;
+    params->fps = p.fps;
+    params->lossless = p.lossLess;
+}
+
+// Parameters of the caller, with the defaults for members it does not know
+// of. Returns an error message if the parameters cannot be used
+static const char *getParams(const luma_enc_params_t *params, luma_enc_params_t &res)
+{
+    luma_enc_params_init(&res);
+    if (params == NULL)
+        return NULL;
+    
+    if (params->struct_size <= sizeof(size_t))
+        return "Parameters not set up with luma_enc_params_init()";
+    if (params->struct_size > sizeof(luma_enc_params_t))
+        return "Parameters are from a newer version of the library";
+    
+    memcpy(&res, params, params->struct_size);
+    res.struct_size = sizeof(luma_enc_params_t);
+    
+    if ((unsigned int)res.ptf > LUMA_PTF_LINEAR || (unsigned int)res.color_space > LUMA_CS_XYZ)
+        return "Unknown transfer function or color space";
+    
+    return NULL;
+}
+
+static void setParams(luma_encoder_t *enc, const luma_enc_params_t *params)
+{
+    LumaEncoderParams p;
+    p.ptf = (LumaQuantizer::ptf_t)params->ptf;
+    p.colorSpace = (LumaQuantizer::colorSpace_t)params->color_space;
+    p.ptfBitDepth = params->ptf_bit_depth;
+    p.colorBitDepth = params->color_bit_depth;
+    p.bitDepth = params->bit_depth;
+    p.profile = params->profile;
+    p.quantizerScale = params->quantizer_scale;
+    p.bitrate = params->bitrate;
+    p.keyframeInterval = params->keyframe_interval;
+    p.preScaling = params->pre_scaling;
+    p.minLum = params->min_lum;
+    p.maxLum = params->max_lum;
+    p.fps = params->fps;
+    p.lossLess = params->lossless != 0;
+    enc->encoder.setParams(p);
+}
+
+static luma_encoder_t *create(const char *outputFile, luma_write_fn write, void *user,
+                              unsigned int width, unsigned int height,
+                              const luma_enc_params_t *params)
+{
+    luma_enc_params_t p;
+    const char *err = getParams(params, p);
+    if (err != NULL)
+    {
+        setError(err);
+        return NULL;
+    }
+    
+    luma_encoder_t *enc = NULL;
+    try
+    {
+        enc = new luma_encoder_t;
+        setParams(enc, &p);
+        enc->width = width;
+        enc->height = height;
+        
+        bool res;
+        if (write != NULL)
+        {
+            enc->output.reset(new LumaCallbackWriter(
+                [write, user](const void *buffer, size_t size) { return write(user, buffer, size) != 0; }));
+            res = enc->encoder.initialize(enc->output.get(), width, height, false);
+        }
+        else
+            res = enc->encoder.initialize(outputFile, width, height);
+        
+        if (!res)
+            throw LumaException("Failed to initialize encoder");
+        
+        return enc;
+    }
+    catch (std::exception &e)
+    {
+        setError(e.what());
+    }
+    catch (...)
+    {
+        setError("Unknown error");
+    }
+    
+    delete enc;
+    return NULL;
+}
+
+luma_encoder_t *luma_enc_create(const char *output_file,
+                                unsigned int width, unsigned int height,
+                                const luma_enc_params_t *params)
+{
+    if (output_file == NULL)
+    {
+        setError("No output file");
+        return NULL;
+    }
+    
+    return create(output_file, NULL, NULL, width, height, params);
+}
+
+luma_encoder_t *luma_enc_create_callback(luma_write_fn write, void *user,
+                                         unsigned int width, unsigned int height,
+                                         const luma_enc_params_t *params)
+{
+    if (write == NULL)
+    {
+        setError("No output function");
+        return NULL;
+    }
+    
+    return create(NULL, write, user, width, height, params);
+}
+
+int luma_enc_push_frame(luma_encoder_t *enc, const luma_image_t *frame)
+{
+    if (enc == NULL)
+        return setError("No encoder", LUMA_INVALID_ARGUMENT);
+    if (enc->finished)
+        return setError("Encoding has been finished", LUMA_INVALID_ARGUMENT);
+    
+    const char *err = lumaImageError(frame, enc->width, enc->height);
+    if (err != NULL)
+        return setError(err, LUMA_INVALID_ARGUMENT);
+    
+    try
+    {
+        if (!enc->encoder.encode(lumaImageView(*frame)))
+            return setError("Failed to encode frame");
+    }
+    catch (std::exception &e)
+    {
+        return setError(e.what());
+    }
+    catch (...)
+    {
+        return setError("Unknown error");
+    }
+    
+    return LUMA_OK;
+}
+
+int luma_enc_finish(luma_encoder_t *enc)
+{
+    if (enc == NULL)
+        return setError("No encoder", LUMA_INVALID_ARGUMENT);
+    if (enc->finished)
+        return LUMA_OK;
+    
+    enc->finished = true;
+    try
+    {
+        enc->encoder.finish();
+    }
+    catch (std::exception &e)
+    {
+        return setError(e.what());
+    }
+    catch (...)
+    {
+        return setError("Unknown error");
+    }
+    
+    return LUMA_OK;
+}
+
+void luma_enc_destroy(luma_encoder_t *enc)
+{
+    if (enc == NULL)
+        return;
+    
+    luma_enc_finish(enc);
+    delete enc;
+}
+
+const char *luma_enc_last_error(void)
+{
+    return s_error.c_str();
+}
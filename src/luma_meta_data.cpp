@@ -0,0 +1,299 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#include "luma_meta_data.h"
+#include "luma_exception.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#define META_DATA_VERSION 0x0200
+#define META_DATA_HEADER_SIZE 36
+
+// Little-endian reading and writing, independent of the byte order of the host
+static void putU16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void putU32(uint8_t *p, uint32_t v)
+{
+    for (int i=0; i<4; i++)
+        p[i] = (v >> 8*i) & 0xFF;
+}
+
+static void putFloat(uint8_t *p, float v)
+{
+    uint32_t u;
+    memcpy(&u, &v, 4);
+    putU32(p, u);
+}
+
+static uint16_t getU16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t getU32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float getFloat(const uint8_t *p)
+{
+    uint32_t u = getU32(p);
+    float v;
+    memcpy(&v, &u, 4);
+    return v;
+}
+
+// Zigzag varints, where small signed values take few bytes
+static void putVarint(std::vector<uint8_t> &record, uint32_t v)
+{
+    v = (v << 1) ^ (0u - (v >> 31));
+    while (v >= 0x80)
+    {
+        record.push_back((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    record.push_back(v);
+}
+
+static bool getVarint(const uint8_t *&p, const uint8_t *end, uint32_t &v)
+{
+    uint32_t z = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (p >= end)
+            return false;
+        z |= (uint32_t)(*p & 0x7F) << shift;
+        if (!(*p++ & 0x80))
+        {
+            v = (z >> 1) ^ (0u - (z & 1));
+            return true;
+        }
+    }
+    return false;
+}
+
+LumaMetaData::LumaMetaData() : ptf(LumaQuantizer::PTF_PSI), colorSpace(LumaQuantizer::CS_LUV),
+    ptfBitDepth(11), colorBitDepth(8), preScaling(1.0f), maxLum(1e4f), minLum(0.005f)
+{}
+
+void LumaMetaData::serialize(std::vector<uint8_t> &record) const
+{
+    record.assign(META_DATA_HEADER_SIZE, 0);
+    record.reserve(META_DATA_HEADER_SIZE + 2*mapping.size());
+    uint8_t *p = &record[0];
+    
+    memcpy(p, "LHDR", 4);
+    putU16(p + 4, META_DATA_VERSION);
+    putU16(p + 6, META_DATA_HEADER_SIZE);
+    p[8] = (uint8_t)ptf;
+    p[9] = (uint8_t)colorSpace;
+    p[10] = (uint8_t)ptfBitDepth;
+    p[11] = (uint8_t)colorBitDepth;
+    putFloat(p + 12, preScaling);
+    putFloat(p + 16, maxLum);
+    putFloat(p + 20, minLum);
+    p[24] = mapping.empty() ? MAPPING_PARAMETRIC : MAPPING_DELTA;
+    putU32(p + 28, (uint32_t)mapping.size());
+    
+    // Second order differences of the bit patterns, up to the trailing
+    // repetitions of the last value
+    size_t n = mapping.size();
+    while (n > 1 && mapping[n-1] == mapping[n-2])
+        n--;
+    uint32_t prev = 0, prevDiff = 0;
+    for (size_t i=0; i<n; i++)
+    {
+        uint32_t u;
+        memcpy(&u, &mapping[i], 4);
+        putVarint(record, (u - prev) - prevDiff);
+        prevDiff = u - prev;
+        prev = u;
+    }
+    putU32(&record[32], (uint32_t)(record.size() - META_DATA_HEADER_SIZE));
+}
+
+bool LumaMetaData::deserialize(const uint8_t *record, size_t size)
+{
+    if (size < META_DATA_HEADER_SIZE || memcmp(record, "LHDR", 4))
+        return false;
+    
+    // Version 1 stored the mapping as float values only
+    const unsigned int major = getU16(record + 4) >> 8;
+    if (major != 1 && major != (META_DATA_VERSION >> 8))
+        throw LumaException("Unsupported version of the Luma HDRv meta data");
+    if (major == 1 && record[24] != MAPPING_FLOAT)
+        return false;
+    
+    const size_t headerSize = getU16(record + 6);
+    const size_t n = getU32(record + 28), bytes = getU32(record + 32);
+    if (headerSize < META_DATA_HEADER_SIZE || headerSize > size || bytes > size - headerSize ||
+        record[8] > LumaQuantizer::PTF_LINEAR || record[9] > LumaQuantizer::CS_XYZ ||
+        record[10] < 1 || record[10] > 16 || record[11] < 1 || record[11] > 16)
+        return false;
+    
+    // A stored mapping has one value for each code value of the PTF, and 
+    // each value takes at least one byte
+    const size_t values = (size_t)1 << record[10];
+    
+    ptf = (LumaQuantizer::ptf_t)record[8];
+    colorSpace = (LumaQuantizer::colorSpace_t)record[9];
+    ptfBitDepth = record[10];
+    colorBitDepth = record[11];
+    preScaling = getFloat(record + 12);
+    maxLum = getFloat(record + 16);
+    minLum = getFloat(record + 20);
+    
+    const uint8_t *p = record + headerSize, *end = p + bytes;
+    switch (record[24])
+    {
+    case MAPPING_FLOAT:
+        if (n != values || bytes != 4*n)
+            return false;
+        mapping.resize(n);
+        for (size_t i=0; i<n; i++, p += 4)
+            mapping[i] = getFloat(p);
+        break;
+    case MAPPING_PARAMETRIC:
+        if (n != 0 || bytes != 0)
+            return false;
+        mapping.clear();
+        break;
+    case MAPPING_DELTA:
+    {
+        // Values are at most 5 bytes, and trailing repetitions are not stored
+        if (n != values || bytes == 0 || bytes > 5*n)
+            return false;
+        mapping.resize(n);
+        uint32_t u = 0, diff = 0, v;
+        size_t i = 0;
+        for (; i<n && p<end; i++)
+        {
+            if (!getVarint(p, end, v))
+                return false;
+            diff += v;
+            u += diff;
+            memcpy(&mapping[i], &u, 4);
+        }
+        if (p != end)
+            return false;
+        std::fill(mapping.begin() + i, mapping.end(), i ? mapping[i-1] : 0.0f);
+        break;
+    }
+    default:
+        return false;
+    }
+    
+    return true;
+}
+
+bool LumaMetaData::deserializeLegacy(unsigned int uid, const uint8_t *buffer, size_t size)
+{
+    // The fields were written from memory, i.e. as 32 bit values in the
+    // byte order of the host, which is little-endian on all platforms the
+    // files have been written on
+    if (size < 4 || (uid == 436 && size < 8))
+        return false;
+    
+    switch (uid)
+    {
+    case 430:
+        ptfBitDepth = getU32(buffer);
+        break;
+    case 431:
+        colorBitDepth = getU32(buffer);
+        break;
+    case 432:
+        ptf = (LumaQuantizer::ptf_t)getU32(buffer);
+        break;
+    case 433:
+        colorSpace = (LumaQuantizer::colorSpace_t)getU32(buffer);
+        break;
+    case 434:
+        mapping.resize(size/4);
+        for (size_t i=0; i<mapping.size(); i++)
+            mapping[i] = getFloat(buffer + 4*i);
+        break;
+    case 435:
+        preScaling = getFloat(buffer);
+        break;
+    case 436:
+        maxLum = getFloat(buffer);
+        minLum = getFloat(buffer + 4);
+        break;
+    default:
+        return false;
+    }
+    
+    return true;
+}
+
+void LumaMetaData::addAttachment(MkvInterface &writer) const
+{
+    std::vector<uint8_t> record;
+    serialize(record);
+    
+    // The buffer is owned, and freed, by the attachment
+    binary *buffer = (binary*)malloc(record.size());
+    if (buffer == NULL)
+        throw LumaException("Cannot allocate memory for meta data");
+    memcpy(buffer, &record[0], record.size());
+    writer.addAttachment(LUMA_META_DATA_UID, buffer, record.size(), "Meta data");
+}
+
+bool LumaMetaData::readAttachments(MkvInterface &reader)
+{
+    binary *buffer;
+    unsigned int ind = 0, id, size, legacy = 0;
+    while (reader.getAttachment(ind++, &buffer, id, size))
+    {
+        if (id == LUMA_META_DATA_UID)
+            return deserialize(buffer, size);
+        if (deserializeLegacy(id, buffer, size))
+            legacy |= 1 << (id - 430);
+    }
+    
+    // Pre-scaling (435) and luminance range (436) are optional
+    const unsigned int required = 0x1F;
+    return (legacy & required) == required;
+}
@@ -0,0 +1,352 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#include "luma_metrics.h"
+#include "luma_exception.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <thread>
+
+// Gaussian window of SSIM, 11x11 with sigma = 1.5
+#define SSIM_RADIUS 5
+static const float ssimWindow[2*SSIM_RADIUS+1] = {
+    0.00102838f, 0.00759876f, 0.03600077f, 0.10936069f, 0.21300554f, 0.26601172f,
+    0.21300554f, 0.10936069f, 0.03600077f, 0.00759876f, 0.00102838f};
+
+// Linear Rec.709 RGB to LMS of ICtCp (ITU-R BT.2100), through BT.2020 primaries
+static const float rgb2lms[3][3] = {
+    { 0.295810f, 0.623086f, 0.081104f },
+    { 0.156251f, 0.727298f, 0.116451f },
+    { 0.035143f, 0.156560f, 0.808296f } };
+
+// PQ (SMPTE ST 2084) encoding of absolute luminance
+float LumaMetrics::pqEncode(float Y)
+{
+    const float m1 = 0.1593017578125f, m2 = 78.84375f,
+                c1 = 0.8359375f, c2 = 18.8515625f, c3 = 18.6875f;
+    float Yp = powf(std::max(Y, 0.0f) / 10000.0f, m1);
+    return powf((c1 + c2*Yp) / (1.0f + c3*Yp), m2);
+}
+
+// PU21 encoding of absolute luminance, banding + glare variant (Mantiuk and
+// Azimi, "PU21: A novel perceptually uniform encoding for adapting existing
+// quality metrics for HDR", PCS 2021)
+float LumaMetrics::puEncode(float Y)
+{
+    const float p[7] = {0.353487901f, 0.3734658629f, 8.277049286e-05f, 0.9062562627f,
+                        0.09150303166f, 0.9099517204f, 596.3148142f};
+    Y = std::min(10000.0f, std::max(0.005f, Y));
+    float Yp = powf(Y, p[3]);
+    return std::max(0.0f, p[6]*(powf((p[0] + p[1]*Yp) / (1.0f + p[2]*Yp), p[4]) - p[5]));
+}
+
+static float log10Fn(float x)
+{
+    return log10f(x);
+}
+
+void LumaMetrics::LogTable::init(float (*fn)(float), float mn, float mx)
+{
+    m_min = mn;
+    m_max = mx;
+    
+    uint32_t b0, b1;
+    memcpy(&b0, &mn, sizeof(float));
+    memcpy(&b1, &mx, sizeof(float));
+    m_base = b0 >> 15;
+    
+    // One extra entry, for interpolation at the maximum
+    m_table.resize((b1 >> 15) - m_base + 2);
+    for (uint32_t i=0; i<m_table.size(); i++)
+    {
+        uint32_t bits = (m_base + i) << 15;
+        float x;
+        memcpy(&x, &bits, sizeof(float));
+        m_table[i] = fn(x);
+    }
+}
+
+static inline double psnr(double sse, size_t pixels, double peak)
+{
+    double mse = pixels ? sse / pixels : 0.0;
+    return mse > 0.0 ? 10.0*log10(peak*peak / mse) : 999.0;
+}
+
+LumaMetrics::LumaMetrics(unsigned int threads, float minLum, float maxLum) :
+    m_threads(threads), m_minLum(minLum), m_maxLum(maxLum), m_width(0), m_height(0)
+{
+    if (!m_threads)
+        m_threads = std::max(1u, std::thread::hardware_concurrency());
+    m_puPeak = puEncode(m_maxLum);
+    
+    // Tables of the transcendental functions, in place of 10 evaluations per pixel
+    m_puTable.init(&LumaMetrics::puEncode, m_minLum, m_maxLum);
+    m_logTable.init(&log10Fn, m_minLum, m_maxLum);
+    m_pqTable.init(&LumaMetrics::pqEncode, 1e-5f, 1e4f);
+    reset();
+}
+
+void LumaMetrics::reset()
+{
+    m_frames = 0;
+    m_pixels = 0;
+    m_puSse = m_logSse = m_ssimSum = m_deltaESum = 0.0;
+}
+
+// Split rows in equally sized ranges, one per thread, and sum the results
+void LumaMetrics::parallelRows(unsigned int rows,
+                               const std::function<void(unsigned int, unsigned int, Sums&)> &fn,
+                               Sums &total)
+{
+    unsigned int n = std::max(1u, std::min(m_threads, rows));
+    std::vector<Sums> sums(n);
+    std::vector<std::thread> threads;
+    
+    for (unsigned int t=1; t<n; t++)
+        threads.push_back(std::thread(fn, t*rows/n, (t+1)*rows/n, std::ref(sums[t])));
+    fn(0, rows/n, sums[0]);
+    for (size_t t=0; t<threads.size(); t++)
+        threads[t].join();
+    
+    for (unsigned int t=0; t<n; t++)
+    {
+        total.puSse += sums[t].puSse;
+        total.logSse += sums[t].logSse;
+        total.ssim += sums[t].ssim;
+        total.deltaE += sums[t].deltaE;
+        total.ssimPixels += sums[t].ssimPixels;
+    }
+}
+
+// Per pixel metrics: PU21 and log luminance errors, and Delta E ITP. The PU21
+// encoded luminance is stored for the SSIM computation
+void LumaMetrics::pixelMetrics(const LumaFrame &reference, const LumaFrame &test,
+                               unsigned int y0, unsigned int y1, Sums &sums)
+{
+    const unsigned int w = m_width;
+    const float *r[3], *t[3];
+    for (unsigned int c=0; c<3; c++)
+    {
+        r[c] = reference.getChannel(c);
+        t[c] = test.getChannel(c);
+    }
+    
+    for (size_t i=(size_t)y0*w; i<(size_t)y1*w; i++)
+    {
+        // Luminance
+        float Yr = 0.212656f*r[0][i] + 0.715158f*r[1][i] + 0.072186f*r[2][i],
+              Yt = 0.212656f*t[0][i] + 0.715158f*t[1][i] + 0.072186f*t[2][i];
+        Yr = std::min(m_maxLum, std::max(m_minLum, Yr));
+        Yt = std::min(m_maxLum, std::max(m_minLum, Yt));
+        
+        m_puRef[i] = m_puTable(Yr);
+        m_puTest[i] = m_puTable(Yt);
+        double d = m_puRef[i] - m_puTest[i];
+        sums.puSse += d*d;
+        
+        d = m_logTable(Yr) - m_logTable(Yt);
+        sums.logSse += d*d;
+        
+        // ICtCp of both frames
+        float itp[2][3];
+        for (unsigned int f=0; f<2; f++)
+        {
+            const float *const *ch = f ? t : r;
+            float lms[3];
+            for (unsigned int k=0; k<3; k++)
+                lms[k] = m_pqTable(rgb2lms[k][0]*ch[0][i] + rgb2lms[k][1]*ch[1][i] + rgb2lms[k][2]*ch[2][i]);
+            
+            itp[f][0] = 0.5f*lms[0] + 0.5f*lms[1];
+            itp[f][1] = 0.5f*(6610.0f*lms[0] - 13613.0f*lms[1] + 7003.0f*lms[2]) / 4096.0f; // T = 0.5 Ct
+            itp[f][2] = (17933.0f*lms[0] - 17390.0f*lms[1] - 543.0f*lms[2]) / 4096.0f;
+        }
+        float dI = itp[0][0]-itp[1][0], dT = itp[0][1]-itp[1][1], dP = itp[0][2]-itp[1][2];
+        sums.deltaE += 720.0f*sqrtf(dI*dI + dT*dT + dP*dP);
+    }
+}
+
+// Horizontal filtering of the SSIM statistics (means, variances and covariance)
+void LumaMetrics::ssimFilterRows(unsigned int y0, unsigned int y1)
+{
+    const unsigned int w = m_width, xe = w - 2*SSIM_RADIUS;
+    std::vector<float> sq1(w), sq2(w), sq12(w);
+    
+    for (unsigned int y=y0; y<y1; y++)
+    {
+        const size_t row = (size_t)y*w;
+        const float *p1 = &m_puRef[row], *p2 = &m_puTest[row];
+        float *mu1 = &m_mu1[row], *mu2 = &m_mu2[row], *s11 = &m_s11[row], *s22 = &m_s22[row], *s12 = &m_s12[row];
+        
+        for (unsigned int x=0; x<w; x++)
+        {
+            sq1[x] = p1[x]*p1[x];
+            sq2[x] = p2[x]*p2[x];
+            sq12[x] = p1[x]*p2[x];
+        }
+        
+        // Output x corresponds to pixel x+SSIM_RADIUS
+        std::fill(mu1, mu1+xe, 0.0f); std::fill(mu2, mu2+xe, 0.0f);
+        std::fill(s11, s11+xe, 0.0f); std::fill(s22, s22+xe, 0.0f); std::fill(s12, s12+xe, 0.0f);
+        for (unsigned int k=0; k<2*SSIM_RADIUS+1; k++)
+        {
+            const float g = ssimWindow[k];
+            for (unsigned int x=0; x<xe; x++)
+            {
+                mu1[x] += g*p1[x+k];
+                mu2[x] += g*p2[x+k];
+                s11[x] += g*sq1[x+k];
+                s22[x] += g*sq2[x+k];
+                s12[x] += g*sq12[x+k];
+            }
+        }
+    }
+}
+
+// Vertical filtering of the SSIM statistics, and summation of the SSIM map.
+// Rows y0 to y1 are output rows, corresponding to pixel rows y+SSIM_RADIUS
+void LumaMetrics::ssimRows(unsigned int y0, unsigned int y1, Sums &sums)
+{
+    const unsigned int w = m_width, xe = w - 2*SSIM_RADIUS;
+    const float C1 = (0.01f*m_puPeak)*(0.01f*m_puPeak), C2 = (0.03f*m_puPeak)*(0.03f*m_puPeak);
+    std::vector<float> mu1(xe), mu2(xe), s11(xe), s22(xe), s12(xe);
+    
+    for (unsigned int y=y0; y<y1; y++)
+    {
+        std::fill(mu1.begin(), mu1.end(), 0.0f); std::fill(mu2.begin(), mu2.end(), 0.0f);
+        std::fill(s11.begin(), s11.end(), 0.0f); std::fill(s22.begin(), s22.end(), 0.0f);
+        std::fill(s12.begin(), s12.end(), 0.0f);
+        for (unsigned int k=0; k<2*SSIM_RADIUS+1; k++)
+        {
+            const float g = ssimWindow[k];
+            const size_t row = (size_t)(y+k)*w;
+            for (unsigned int x=0; x<xe; x++)
+            {
+                mu1[x] += g*m_mu1[row+x];
+                mu2[x] += g*m_mu2[row+x];
+                s11[x] += g*m_s11[row+x];
+                s22[x] += g*m_s22[row+x];
+                s12[x] += g*m_s12[row+x];
+            }
+        }
+        
+        double sum = 0.0;
+        for (unsigned int x=0; x<xe; x++)
+        {
+            float m11 = mu1[x]*mu1[x], m22 = mu2[x]*mu2[x], m12 = mu1[x]*mu2[x];
+            sum += ((2.0f*m12 + C1)*(2.0f*(s12[x] - m12) + C2)) /
+                   ((m11 + m22 + C1)*((s11[x] - m11) + (s22[x] - m22) + C2));
+        }
+        sums.ssim += sum;
+        sums.ssimPixels += xe;
+    }
+}
+
+// Compare a frame with its reference. Frames need at least 3 (RGB) channels
+LumaMetricsResult LumaMetrics::compare(const LumaFrame &reference, const LumaFrame &test)
+{
+    if (reference.width != test.width || reference.height != test.height)
+        throw LumaException("Size of frame does not match the reference");
+    if (reference.channels < 3 || test.channels < 3)
+        throw LumaException("Metrics require RGB frames");
+    
+    m_width = reference.width;
+    m_height = reference.height;
+    const size_t size = (size_t)m_width*m_height;
+    if (m_puRef.size() != size)
+    {
+        m_puRef.resize(size); m_puTest.resize(size);
+        m_mu1.resize(size); m_mu2.resize(size);
+        m_s11.resize(size); m_s22.resize(size); m_s12.resize(size);
+    }
+    
+    using namespace std::placeholders;
+    Sums sums;
+    parallelRows(m_height, std::bind(&LumaMetrics::pixelMetrics, this, std::cref(reference), std::cref(test), _1, _2, _3), sums);
+    
+    // SSIM over the pixels where the window fits in the frame
+    double ssim = 1.0;
+    if (m_width > 2*SSIM_RADIUS && m_height > 2*SSIM_RADIUS)
+    {
+        Sums dummy;
+        parallelRows(m_height, [this](unsigned int y0, unsigned int y1, Sums&) { ssimFilterRows(y0, y1); }, dummy);
+        parallelRows(m_height - 2*SSIM_RADIUS, std::bind(&LumaMetrics::ssimRows, this, _1, _2, _3), sums);
+        ssim = sums.ssim / sums.ssimPixels;
+    }
+    
+    LumaMetricsResult res;
+    res.puPsnr = psnr(sums.puSse, size, m_puPeak);
+    res.logPsnr = psnr(sums.logSse, size, log10(m_maxLum) - log10(m_minLum));
+    res.puSsim = ssim;
+    res.deltaEitp = sums.deltaE / size;
+    
+    // Accumulate over frames
+    m_frames++;
+    m_pixels += size;
+    m_puSse += sums.puSse;
+    m_logSse += sums.logSse;
+    m_ssimSum += ssim;
+    m_deltaESum += sums.deltaE;
+    
+    return res;
+}
+
+// Results over all frames. PSNRs are computed from the mean squared error of
+// all pixels, and SSIM is the mean of the frames
+LumaMetricsResult LumaMetrics::mean() const
+{
+    LumaMetricsResult res;
+    if (!m_frames)
+        return res;
+    
+    res.puPsnr = psnr(m_puSse, m_pixels, m_puPeak);
+    res.logPsnr = psnr(m_logSse, m_pixels, log10(m_maxLum) - log10(m_minLum));
+    res.puSsim = m_ssimSum / m_frames;
+    res.deltaEitp = m_deltaESum / m_pixels;
+    
+    return res;
+}
+
+std::string LumaMetrics::json(const LumaMetricsResult &res) const
+{
+    char str[256];
+    snprintf(str, 256, "{\"pu_psnr\": %.4f, \"log_psnr\": %.4f, \"pu_ssim\": %.6f, \"delta_e_itp\": %.4f}",
+             res.puPsnr, res.logPsnr, res.puSsim, res.deltaEitp);
+    return str;
+}
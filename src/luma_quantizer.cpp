@@ -37,10 +37,92 @@
  */
 
 #include "luma_quantizer.h"
+#include "luma_exception.h"
 
 #include <stdio.h>
+#include <string.h>
+#include <stdint.h>
 #include <math.h>
 #include <algorithm>
+#include <map>
+#include <tuple>
+#include <mutex>
+
+// Tabulated PTFs, stored in this translation unit only
+static const float ptf_jnd_ferwerda_10bit[] = {
+#include "ptfs/ptf_jnd_ferwerda_10bit.h"
+};
+
+static const float ptf_jnd_ferwerda_11bit[] = {
+#include "ptfs/ptf_jnd_ferwerda_11bit.h"
+};
+
+static const float ptf_jnd_ferwerda_12bit[] = {
+#include "ptfs/ptf_jnd_ferwerda_12bit.h"
+};
+
+static const float ptf_jnd_hdrvdp_10bit[] = {
+#include "ptfs/ptf_jnd_hdrvdp_10bit.h"
+};
+
+static const float ptf_jnd_hdrvdp_11bit[] = {
+#include "ptfs/ptf_jnd_hdrvdp_11bit.h"
+};
+
+static const float ptf_jnd_hdrvdp_12bit[] = {
+#include "ptfs/ptf_jnd_hdrvdp_12bit.h"
+};
+
+// Mappings that have been computed, by PTF, bit depth and luminance range
+typedef std::tuple<int, unsigned int, float, float> MappingKey;
+static std::map<MappingKey, std::shared_ptr<const std::vector<float> > > mappingCache;
+static std::mutex mappingCacheMutex;
+
+// Tables of the PQ function, normalized to a peak luminance of 1, for
+// evaluation by linear interpolation. The encoding table is indexed by the
+// bits of the float luminance, which gives segments that are uniform in each
+// octave, in 2^-50 - 1. The decoding table is uniform in PQ values 0 - 1
+struct PQTables
+{
+    static const unsigned int encodeOctaves = 50, encodeBits = 6,
+                              encodeShift = 23 - encodeBits,
+                              encodeSize = encodeOctaves << encodeBits,
+                              decodeSize = 8192;
+    
+    PQTables()
+    {
+        const double m = 78.8438, n = 0.1593,
+                     c1 = 0.8359, c2 = 18.8516, c3 = 18.6875;
+        
+        const float lmin = ldexpf(1.0f, -(int)encodeOctaves);
+        memcpy(&encodeMin, &lmin, sizeof(float));
+        encodeMax = encodeMin + (encodeSize << encodeShift);
+        
+        for (uint32_t i = 0; i <= encodeSize; i++)
+        {
+            const uint32_t bits = encodeMin + (i << encodeShift);
+            float l;
+            memcpy(&l, &bits, sizeof(float));
+            const double Lp = pow((double)l, n);
+            encode[i] = (float)pow((c1 + c2*Lp) / (1 + c3*Lp), m);
+        }
+        
+        for (uint32_t i = 0; i <= decodeSize; i++)
+        {
+            const double Vp = pow((double)i/decodeSize, 1.0/m);
+            decode[i] = (float)pow(std::max(0.0, Vp-c1) / (c2-c3*Vp), 1.0/n);
+        }
+    }
+    
+    uint32_t encodeMin, encodeMax;
+    float encode[encodeSize+1], decode[decodeSize+1];
+};
+
+static const PQTables &pqTables()
+{
+    static const PQTables tables;
+    return tables;
+}
 
 LumaQuantizer::LumaQuantizer()
 {
@@ -53,8 +135,6 @@ LumaQuantizer::LumaQuantizer()
 
 LumaQuantizer::~LumaQuantizer()
 {
-    if (m_mapping != NULL)
-        delete[] m_mapping;
 }
 
 // Names of perceptual transfer functions
@@ -111,61 +191,70 @@ std::string LumaQuantizer::name(colorSpace_t cs)
 }
 
 // Define PQ mapping
-void LumaQuantizer::setMappingPQ()
+void LumaQuantizer::setMappingPQ(float *mapping)
 {
     for (size_t i=0; i<=m_maxVal; i++)
-	    m_mapping[i] = transformPQ((float)i/m_maxVal, 0);
+	    mapping[i] = transformPQ((float)i/m_maxVal, 0);
 }
 
 // Define log mapping
-void LumaQuantizer::setMappingLog()
+void LumaQuantizer::setMappingLog(float *mapping)
 {
     for (size_t i=0; i<=m_maxVal; i++)
-        m_mapping[i] = transformLog((float)i/m_maxVal, 0);
+        mapping[i] = transformLog((float)i/m_maxVal, 0);
 }
 
 // Define JND HDR-VDP2 mapping
-void LumaQuantizer::setMappingJNDHDRVDP()
+void LumaQuantizer::setMappingJNDHDRVDP(float *mapping)
 {
-    const float *mapping;
+    const float *table;
+    size_t size;
     switch (m_bitdepth)
     {
     case 10:
-        mapping = ptf_jnd_hdrvdp_10bit;
+        table = ptf_jnd_hdrvdp_10bit;
+        size = sizeof(ptf_jnd_hdrvdp_10bit)/sizeof(float);
         break;
     case 11:
-        mapping = ptf_jnd_hdrvdp_11bit;
+        table = ptf_jnd_hdrvdp_11bit;
+        size = sizeof(ptf_jnd_hdrvdp_11bit)/sizeof(float);
         break;
     case 12:
     default:
-        mapping = ptf_jnd_hdrvdp_12bit;
+        table = ptf_jnd_hdrvdp_12bit;
+        size = sizeof(ptf_jnd_hdrvdp_12bit)/sizeof(float);
         break;
     }
     
+    // Bit depths above 12 repeat the last value of the table
     for (size_t i=0; i<=m_maxVal; i++)
-        m_mapping[i] = mapping[i];
+        mapping[i] = table[std::min(i, size-1)];
 }
 
 // Define mapping from original HDR video encdoing paper
-void LumaQuantizer::setMappingPsi()
+void LumaQuantizer::setMappingPsi(float *mapping)
 {
-    const float *mapping;
+    const float *table;
+    size_t size;
     switch (m_bitdepth)
     {
     case 10:
-        mapping = ptf_jnd_ferwerda_10bit;
+        table = ptf_jnd_ferwerda_10bit;
+        size = sizeof(ptf_jnd_ferwerda_10bit)/sizeof(float);
         break;
     case 11:
-        mapping = ptf_jnd_ferwerda_11bit;
+        table = ptf_jnd_ferwerda_11bit;
+        size = sizeof(ptf_jnd_ferwerda_11bit)/sizeof(float);
         break;
     case 12:
     default:
-        mapping = ptf_jnd_ferwerda_12bit;
+        table = ptf_jnd_ferwerda_12bit;
+        size = sizeof(ptf_jnd_ferwerda_12bit)/sizeof(float);
         break;
     }
     
     for (size_t i=0; i<=m_maxVal; i++)
-        m_mapping[i] = mapping[i];
+        mapping[i] = table[std::min(i, size-1)];
 }
 
 // Specify the quanizer to use, which includes ptf, color space and their respective bit depths
@@ -173,9 +262,6 @@ void LumaQuantizer::setQuantizer(ptf_t ptf, unsigned int bitdepth,
                                  colorSpace_t cs, unsigned int bitdepthC,
                                  float maxLum, float minLum)
 {
-    if (m_mapping != NULL)
-        delete[] m_mapping;
-    
     m_bitdepth = bitdepth;
     m_maxVal = (int)pow(2.0f,(float)bitdepth)-1;
     m_colorSpace = cs;
@@ -184,31 +270,64 @@ void LumaQuantizer::setQuantizer(ptf_t ptf, unsigned int bitdepth,
     m_Lmax = maxLum;
     m_Lmin = minLum;
     
-    m_mapping = new float[m_maxVal+1];
+    // The tabulated PTFs do not depend on the luminance range
+    const MappingKey key(ptf, bitdepth, tabulated(ptf) ? 0.0f : maxLum, tabulated(ptf) ? 0.0f : minLum);
+    {
+        std::lock_guard<std::mutex> lock(mappingCacheMutex);
+        std::map<MappingKey, std::shared_ptr<const std::vector<float> > >::iterator it = mappingCache.find(key);
+        if (it != mappingCache.end())
+        {
+            m_table = it->second;
+            m_mapping = &(*m_table)[0];
+            return;
+        }
+    }
+    
+    std::shared_ptr<std::vector<float> > table = std::make_shared<std::vector<float> >(m_maxVal+1);
+    float *mapping = &(*table)[0];
     
     switch (ptf)
     {
     case PTF_PQ:
-        setMappingPQ();
+        setMappingPQ(mapping);
         break;
     case PTF_LOG:
-        setMappingLog();
+        setMappingLog(mapping);
         break;
     case PTF_JND_HDRVDP:
-        setMappingJNDHDRVDP();
+        setMappingJNDHDRVDP(mapping);
         break;
     case PTF_LINEAR:
         for (size_t i=0; i<=m_maxVal; i++)
-	        m_mapping[i] = m_Lmax*((float)i/m_maxVal);
+	        mapping[i] = m_Lmax*((float)i/m_maxVal);
 	    break;
     case PTF_PSI:
     default:
-        setMappingPsi();
+        setMappingPsi(mapping);
         break;
     }
     
     //for (int i = 0; i<=m_maxVal; i++)
-    //    fprintf(stderr, "%0.8f, ", m_mapping[i]);
+    //    fprintf(stderr, "%0.8f, ", mapping[i]);
+    
+    // If another thread computed the same mapping meanwhile, its copy is used
+    std::lock_guard<std::mutex> lock(mappingCacheMutex);
+    m_table = mappingCache.insert(std::make_pair(key, table)).first->second;
+    m_mapping = &(*m_table)[0];
+}
+
+// Replace the mapping with a custom one, e.g. the mapping stored in a video.
+// Entries after the first n are kept from the mapping of setQuantizer()
+void LumaQuantizer::setMapping(const float *mapping, size_t n)
+{
+    if (m_mapping == NULL)
+        throw LumaException("Quantizer has to be set before its mapping");
+    
+    std::shared_ptr<std::vector<float> > table =
+        std::make_shared<std::vector<float> >(m_mapping, m_mapping + m_maxVal + 1);
+    std::copy(mapping, mapping + std::min(n, table->size()), table->begin());
+    m_table = table;
+    m_mapping = &(*m_table)[0];
 }
 
 // Run quantizer on a pixel value
@@ -264,112 +383,117 @@ float LumaQuantizer::dequantize(const float val, const unsigned int ch) const
 }
 
 // Color transformation of a frame
-bool LumaQuantizer::transformColorSpace(LumaFrame *frame, bool toCs, float sc)
+// Transformation from RGB of a number of pixels, to the color space of the
+// encoding. The output can be the same as the input, for in place transformation
+bool LumaQuantizer::transformToCs(const float *R, const float *G, const float *B,
+                                  float *ch0, float *ch1, float *ch2, size_t n, float sc)
 {
-    if (toCs)
+    switch (m_colorSpace)
     {
-        switch (m_colorSpace)
+    case CS_XYZ:
+        //fprintf(stderr, "Color transformation: RGB --> XYZ\n");
         {
-        case CS_XYZ:
-            //fprintf(stderr, "Color transformation: RGB --> XYZ\n");
-            {
-            int index = 0;
-            float R, G, B;
-            for( unsigned int r = 0; r < frame->height; r++ )
-                for( unsigned int c = 0; c < frame->width; c++, index++ )
-                {
-                    R = frame->getChannel(0)[index]*sc;
-                    G = frame->getChannel(1)[index]*sc;
-                    B = frame->getChannel(2)[index]*sc;
-                    
-                    frame->getChannel(0)[index] = std::max(std::min(rgb2xyzMat[0][0]*R + rgb2xyzMat[0][1]*G + rgb2xyzMat[0][2]*B, 100000000.0f), 0.0001f);
-                    frame->getChannel(1)[index] = std::max(std::min(rgb2xyzMat[1][0]*R + rgb2xyzMat[1][1]*G + rgb2xyzMat[1][2]*B, 100000000.0f), 0.0001f);
-                    frame->getChannel(2)[index] = std::max(std::min(rgb2xyzMat[2][0]*R + rgb2xyzMat[2][1]*G + rgb2xyzMat[2][2]*B, 100000000.0f), 0.0001f);
-                }
-            }
-            break;
-        case CS_LUV:
-            //fprintf(stderr, "Color transformation: RGB --> LUV\n");
-            {
-            int index = 0;
-            float R, G, B, X, Y, Z, sum, x, y;
-            for( unsigned int r = 0; r < frame->height; r++ )
-                for( unsigned int c = 0; c < frame->width; c++, index++ )
-                {
-                    // RGB --> XYZ
-                    R = frame->getChannel(0)[index]*sc;
-                    G = frame->getChannel(1)[index]*sc;
-                    B = frame->getChannel(2)[index]*sc;
-                    X = std::max(std::min(rgb2xyzMat[0][0]*R + rgb2xyzMat[0][1]*G + rgb2xyzMat[0][2]*B, 100000000.0f), 0.0001f);
-                    Y = std::max(std::min(rgb2xyzMat[1][0]*R + rgb2xyzMat[1][1]*G + rgb2xyzMat[1][2]*B, 100000000.0f), 0.0001f);
-                    Z = std::max(std::min(rgb2xyzMat[2][0]*R + rgb2xyzMat[2][1]*G + rgb2xyzMat[2][2]*B, 100000000.0f), 0.0001f);
+        float r, g, b;
+        for( size_t i = 0; i < n; i++ )
+        {
+            r = R[i]*sc;
+            g = G[i]*sc;
+            b = B[i]*sc;
             
-                    // XYZ -> LUV
-                    sum = X + Y + Z;
-                    x = X/sum;
-                    y = Y/sum;
-                    frame->getChannel(0)[index] = Y;
-                    frame->getChannel(1)[index] = 4.0f*x/(-2.0f*x + 12.0f*y + 3.0f) * 410.f/255.0f;
-                    frame->getChannel(2)[index] = 9.0f*y/(-2.0f*x + 12.0f*y + 3.0f) * 410.f/255.0f;
-                }
-            }
-            break;
-        case CS_YCBCR:
-            //fprintf(stderr, "Color transformation: RGB --> YCbCr\n");
-            {
-            // According to BT.2020
-            unsigned int index = 0;
-            /*
-            float maxU = 0.0f, maxV = 0.0f;
-            float minU = 1e10f, minV = 1e10f;
-            float meanU = 0.0f, meanV = 0.0f;
-            */
-            float R, G, B, y;
-            for( unsigned int r = 0; r < frame->height; r++ )
-                for( unsigned int c = 0; c < frame->width; c++, index++ )
-                {
-                    R = transformPQ(std::max(frame->getChannel(0)[index]*sc, 1e-10f), 1);
-                    G = transformPQ(std::max(frame->getChannel(1)[index]*sc, 1e-10f), 1);
-                    B = transformPQ(std::max(frame->getChannel(2)[index]*sc, 1e-10f), 1);
-                    
-                    y = 0.2627f*R + 0.6780f*G + 0.0593f*B;
-                
-                    frame->getChannel(0)[index] = transformPQ((219.0f*y + 16.0f) / 255.0f, 0);
-                    frame->getChannel(1)[index] = (224.0f*( (B - y) / 1.8814f ) + 128.0f) / 255.0f;
-                    frame->getChannel(2)[index] = (224.0f*( (R - y) / 1.4746f ) + 128.0f) / 255.0f;
-                    
-                    /*
-                    maxU = std::max(maxU, frame->getChannel(1)[index]);
-                    maxV = std::max(maxV, frame->getChannel(2)[index]);
-                    minU = std::min(minU, frame->getChannel(1)[index]);
-                    minV = std::min(minV, frame->getChannel(2)[index]);
-                    meanU += frame->getChannel(1)[index];
-                    meanV += frame->getChannel(2)[index];
-                    */
-                }
-            //fprintf(stderr, "max CbCr = [%f, %f]\n", maxU, maxV);
-            //fprintf(stderr, "min CbCr = [%f, %f]\n", minU, minV);
-            //fprintf(stderr, "mean CbCr = [%f, %f]\n", meanU/index, meanV/index);
-            }
-            break;
-        case CS_RGB:
-            //fprintf(stderr, "Color transformation: RGB --> RGB\n");
-            {
-            unsigned int index = 0;
-            for( unsigned int r = 0; r < frame->height; r++ )
-                for( unsigned int c = 0; c < frame->width; c++, index++ )
-                {
-                    frame->getChannel(0)[index]*=sc;
-                    frame->getChannel(1)[index]*=sc;
-                    frame->getChannel(2)[index]*=sc;
-                }
-            break;
-            }
-        default:
-            fprintf(stderr, "Error! Unrecognized color transformation XYZ --> ?\n");
-            return false;
-            break;
+            ch0[i] = std::max(std::min(rgb2xyzMat[0][0]*r + rgb2xyzMat[0][1]*g + rgb2xyzMat[0][2]*b, 100000000.0f), 0.0001f);
+            ch1[i] = std::max(std::min(rgb2xyzMat[1][0]*r + rgb2xyzMat[1][1]*g + rgb2xyzMat[1][2]*b, 100000000.0f), 0.0001f);
+            ch2[i] = std::max(std::min(rgb2xyzMat[2][0]*r + rgb2xyzMat[2][1]*g + rgb2xyzMat[2][2]*b, 100000000.0f), 0.0001f);
         }
+        }
+        break;
+    case CS_LUV:
+        //fprintf(stderr, "Color transformation: RGB --> LUV\n");
+        {
+        float r, g, b, X, Y, Z, sum, x, y;
+        for( size_t i = 0; i < n; i++ )
+        {
+            // RGB --> XYZ
+            r = R[i]*sc;
+            g = G[i]*sc;
+            b = B[i]*sc;
+            X = std::max(std::min(rgb2xyzMat[0][0]*r + rgb2xyzMat[0][1]*g + rgb2xyzMat[0][2]*b, 100000000.0f), 0.0001f);
+            Y = std::max(std::min(rgb2xyzMat[1][0]*r + rgb2xyzMat[1][1]*g + rgb2xyzMat[1][2]*b, 100000000.0f), 0.0001f);
+            Z = std::max(std::min(rgb2xyzMat[2][0]*r + rgb2xyzMat[2][1]*g + rgb2xyzMat[2][2]*b, 100000000.0f), 0.0001f);
+            
+            // XYZ -> LUV
+            sum = X + Y + Z;
+            x = X/sum;
+            y = Y/sum;
+            ch0[i] = Y;
+            ch1[i] = 4.0f*x/(-2.0f*x + 12.0f*y + 3.0f) * 410.f/255.0f;
+            ch2[i] = 9.0f*y/(-2.0f*x + 12.0f*y + 3.0f) * 410.f/255.0f;
+        }
+        }
+        break;
+    case CS_YCBCR:
+        //fprintf(stderr, "Color transformation: RGB --> YCbCr\n");
+        {
+        // According to BT.2020
+        float r, g, b, y;
+        for( size_t i = 0; i < n; i++ )
+        {
+            r = encodePQ(std::max(R[i]*sc, 1e-10f));
+            g = encodePQ(std::max(G[i]*sc, 1e-10f));
+            b = encodePQ(std::max(B[i]*sc, 1e-10f));
+            
+            y = 0.2627f*r + 0.6780f*g + 0.0593f*b;
+        
+            ch0[i] = decodePQ((219.0f*y + 16.0f) / 255.0f);
+            ch1[i] = (224.0f*( (b - y) / 1.8814f ) + 128.0f) / 255.0f;
+            ch2[i] = (224.0f*( (r - y) / 1.4746f ) + 128.0f) / 255.0f;
+        }
+        }
+        break;
+    case CS_RGB:
+        //fprintf(stderr, "Color transformation: RGB --> RGB\n");
+        for( size_t i = 0; i < n; i++ )
+        {
+            ch0[i] = R[i]*sc;
+            ch1[i] = G[i]*sc;
+            ch2[i] = B[i]*sc;
+        }
+        break;
+    default:
+        fprintf(stderr, "Error! Unrecognized color transformation XYZ --> ?\n");
+        return false;
+        break;
+    }
+    
+    return true;
+}
+
+// Transformation of an image in caller owned memory, to the color space of the
+// encoding. Each row is converted from the format of the image while it is
+// transformed, and the image is not modified
+bool LumaQuantizer::transformColorSpace(const LumaImageView &image, LumaFrame *frame, float sc)
+{
+    const unsigned int w = image.width;
+    frame->resize(w, image.height, 3);
+    m_rowBuffer.resize(3*(size_t)w);
+    
+    for (unsigned int y = 0; y < image.height; y++)
+    {
+        const size_t offset = (size_t)y*w;
+        if (!transformToCs(image.row(0, y, &m_rowBuffer[0]), image.row(1, y, &m_rowBuffer[w]), image.row(2, y, &m_rowBuffer[2*w]),
+                           frame->getChannel(0) + offset, frame->getChannel(1) + offset, frame->getChannel(2) + offset, w, sc))
+            return false;
+    }
+    
+    return true;
+}
+
+bool LumaQuantizer::transformColorSpace(LumaFrame *frame, bool toCs, float sc)
+{
+    if (toCs)
+    {
+        float *ch0 = frame->getChannel(0), *ch1 = frame->getChannel(1), *ch2 = frame->getChannel(2);
+        if (!transformToCs(ch0, ch1, ch2, ch0, ch1, ch2, (size_t)frame->width*frame->height, sc))
+            return false;
     }
     else
     {
@@ -444,7 +568,7 @@ bool LumaQuantizer::transformColorSpace(LumaFrame *frame, bool toCs, float sc)
             for( unsigned int r = 0; r < frame->height; r++ )
                 for( unsigned int c = 0; c < frame->width; c++, index++ )
                 {
-                    y = transformPQ(frame->getChannel(0)[index], 1);
+                    y = encodePQ(frame->getChannel(0)[index]);
                     y = (255.0f*y - 16.0f) / 219.0f;
                     blue = y + 1.8814f * (255.0f*frame->getChannel(1)[index] - 128.0f) / 224.0f;
                     red = y + 1.4746f * (255.0f*frame->getChannel(2)[index] - 128.0f) / 224.0f;
@@ -454,9 +578,9 @@ bool LumaQuantizer::transformColorSpace(LumaFrame *frame, bool toCs, float sc)
                     green = std::max(0.0f, std::min(1.0f, green));
                     blue = std::max(0.0f, std::min(1.0f, blue));
                     
-                    frame->getChannel(0)[index] = transformPQ(red, 0)/sc;
-                    frame->getChannel(1)[index] = transformPQ(green, 0)/sc;
-                    frame->getChannel(2)[index] = transformPQ(blue, 0)/sc;
+                    frame->getChannel(0)[index] = decodePQ(red)/sc;
+                    frame->getChannel(1)[index] = decodePQ(green)/sc;
+                    frame->getChannel(2)[index] = decodePQ(blue)/sc;
                     
                     /*
                     maxC[0] = std::max(maxC[0], frame->getChannel(0)[index]);
@@ -482,7 +606,7 @@ bool LumaQuantizer::transformColorSpace(LumaFrame *frame, bool toCs, float sc)
 }
 
 // PQ function
-float LumaQuantizer::transformPQ(float val, bool encode)
+float LumaQuantizer::transformPQ(float val, bool encode) const
 {
     const float L = m_Lmax,
 	      		m = 78.8438, n = 0.1593,
@@ -500,6 +624,37 @@ float LumaQuantizer::transformPQ(float val, bool encode)
     }
 }
 
+// PQ encoding from the tables. Luminances outside of the table, which are
+// above the peak luminance or negligible, are transformed directly
+float LumaQuantizer::encodePQ(float val) const
+{
+    const PQTables &pq = pqTables();
+    const float l = val / m_Lmax;
+    uint32_t bits;
+    memcpy(&bits, &l, sizeof(float));
+    
+    // Negative values and NaN also have larger bit patterns
+    if (bits < pq.encodeMin || bits >= pq.encodeMax)
+        return transformPQ(val, 1);
+    
+    const uint32_t offset = bits - pq.encodeMin, i = offset >> PQTables::encodeShift;
+    const float t = (offset & ((1 << PQTables::encodeShift) - 1)) * (1.0f / (1 << PQTables::encodeShift));
+    return pq.encode[i] + t*(pq.encode[i+1] - pq.encode[i]);
+}
+
+// PQ decoding from the tables
+float LumaQuantizer::decodePQ(float val) const
+{
+    const PQTables &pq = pqTables();
+    if (!(val >= 0.0f && val <= 1.0f))
+        return transformPQ(val, 0);
+    
+    const float p = val * PQTables::decodeSize;
+    const unsigned int i = std::min((unsigned int)p, PQTables::decodeSize - 1);
+    const float t = p - i;
+    return m_Lmax * (pq.decode[i] + t*(pq.decode[i+1] - pq.decode[i]));
+}
+
 // Log function
 float LumaQuantizer::transformLog(float val, bool encode)
 {
@@ -0,0 +1,166 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 7 2015
+ */
+
+#include "luma_stats.h"
+
+#include <string.h>
+
+// Names of pipeline stages
+const char *LumaStats::name(stage_t stage)
+{
+    switch (stage)
+    {
+    case STAGE_TRANSFORM:
+        return "transform";
+    case STAGE_QUANTIZE:
+        return "quantize";
+    case STAGE_CODEC:
+        return "codec";
+    case STAGE_MUX:
+        return "mux";
+    case STAGE_IO:
+        return "io";
+    default:
+        return "unknown";
+    }
+}
+
+void LumaStats::reset()
+{
+    for (int s=0; s<STAGE_NR; s++)
+        m_totalNs[s] = m_lastNs[s] = m_frameNs[s] = 0;
+    m_frames = m_bytes = m_lastBytes = m_frameBytes = m_keyframes = 0;
+    m_queues.clear();
+}
+
+// Count a compressed frame packet
+void LumaStats::addPacket(size_t bytes, bool keyframe)
+{
+    m_bytes += bytes;
+    m_frameBytes += bytes;
+    if (keyframe)
+        m_keyframes++;
+}
+
+// Close the accounting of the current frame. Totals are updated continuously
+void LumaStats::endFrame()
+{
+    for (int s=0; s<STAGE_NR; s++)
+    {
+        m_lastNs[s] = m_frameNs[s];
+        m_frameNs[s] = 0;
+    }
+    m_lastBytes = m_frameBytes;
+    m_frameBytes = 0;
+    m_frames++;
+}
+
+// Sample the current depth of a named frame queue
+void LumaStats::setQueueDepth(const char *queue, unsigned int depth)
+{
+    size_t q = 0;
+    while (q < m_queues.size() && strcmp(m_queues[q].name.c_str(), queue))
+        q++;
+    
+    if (q == m_queues.size())
+    {
+        Queue nq;
+        nq.name = queue;
+        nq.depth = nq.maxDepth = 0;
+        nq.sum = nq.samples = 0;
+        m_queues.push_back(nq);
+    }
+    
+    Queue &qu = m_queues[q];
+    qu.depth = depth;
+    qu.maxDepth = depth > qu.maxDepth ? depth : qu.maxDepth;
+    qu.sum += depth;
+    qu.samples++;
+}
+
+void LumaStats::print(FILE *out) const
+{
+    const double n = m_frames ? (double)m_frames : 1.0;
+    
+    fprintf(out, "\nStatistics:\n");
+    fprintf(out, "-------------------------------------------------------------------\n");
+    fprintf(out, "Frames:                    %llu\n", (unsigned long long)m_frames);
+    fprintf(out, "Keyframes:                 %llu\n", (unsigned long long)m_keyframes);
+    fprintf(out, "Compressed size:           %llu bytes (%.1f bytes/frame)\n", 
+            (unsigned long long)m_bytes, m_bytes/n);
+    fprintf(out, "Stage timings (total / mean per frame / last frame, ms):\n");
+    for (int s=0; s<STAGE_NR; s++)
+        fprintf(out, "  %-10s %12.2f %10.3f %10.3f\n", name((stage_t)s), 
+                1e-6*m_totalNs[s], 1e-6*m_totalNs[s]/n, 1e-6*m_lastNs[s]);
+    for (size_t q=0; q<m_queues.size(); q++)
+        fprintf(out, "Queue '%s': mean depth %.2f, max depth %u\n", m_queues[q].name.c_str(),
+                m_queues[q].samples ? (double)m_queues[q].sum/m_queues[q].samples : 0.0, 
+                m_queues[q].maxDepth);
+    fprintf(out, "-------------------------------------------------------------------\n");
+}
+
+std::string LumaStats::json() const
+{
+    char str[500];
+    std::string res;
+    
+    snprintf(str, 499, "{\n  \"frames\": %llu,\n  \"keyframes\": %llu,\n  \"bytes\": %llu,\n  \"last_frame_bytes\": %llu,\n  \"stages\": {",
+             (unsigned long long)m_frames, (unsigned long long)m_keyframes, 
+             (unsigned long long)m_bytes, (unsigned long long)m_lastBytes);
+    res += str;
+    
+    for (int s=0; s<STAGE_NR; s++)
+    {
+        snprintf(str, 499, "%s\n    \"%s\": {\"total_ns\": %llu, \"last_frame_ns\": %llu}", 
+                 s ? "," : "", name((stage_t)s), 
+                 (unsigned long long)m_totalNs[s], (unsigned long long)m_lastNs[s]);
+        res += str;
+    }
+    res += "\n  },\n  \"queues\": {";
+    
+    for (size_t q=0; q<m_queues.size(); q++)
+    {
+        snprintf(str, 499, "%s\n    \"%s\": {\"depth\": %u, \"max_depth\": %u, \"mean_depth\": %.3f}",
+                 q ? "," : "", m_queues[q].name.c_str(), m_queues[q].depth, m_queues[q].maxDepth,
+                 m_queues[q].samples ? (double)m_queues[q].sum/m_queues[q].samples : 0.0);
+        res += str;
+    }
+    res += "\n  }\n}\n";
+    
+    return res;
+}
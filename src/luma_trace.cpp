@@ -0,0 +1,194 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 7 2015
+ */
+
+#include "luma_trace.h"
+#include "luma_stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#define TRACE_CHUNK_SIZE 16384
+#define TRACE_MAX_CHUNKS 1024
+
+// Event buffer of one thread. Only the owning thread appends events and 
+// allocates chunks, and the event count is published with release semantics
+// for the trace writer. The chunk table is fixed, so that the writer never
+// reads it while it is reallocated, and the count is never reset. Instead, 
+// the writer keeps track of the events it has already written
+struct LumaTrace::Buffer
+{
+    Buffer(unsigned int t) : tid(t), next(NULL), count(0), written(0)
+    {
+        for (size_t i=0; i<TRACE_MAX_CHUNKS; i++)
+            chunks[i] = NULL;
+    }
+    
+    unsigned int tid;
+    Buffer *next;
+    Event *chunks[TRACE_MAX_CHUNKS];
+    std::atomic<size_t> count;
+    size_t written; // only accessed by start() and stop()
+};
+
+std::atomic<bool> LumaTrace::s_enabled(false);
+std::atomic<LumaTrace::Buffer*> LumaTrace::s_buffers(NULL);
+std::atomic<unsigned int> LumaTrace::s_threads(0);
+std::string LumaTrace::s_outputFile;
+
+// Enable tracing. The trace is written to the output file on stop() or exit
+bool LumaTrace::start(const char *outputFile)
+{
+    if (outputFile == NULL || outputFile[0] == 0)
+        return false;
+    
+    static bool registered = false;
+    if (!registered)
+    {
+        atexit(LumaTrace::stop);
+        registered = true;
+    }
+    
+    s_outputFile = outputFile;
+    
+    // Skip events recorded before this trace
+    for (Buffer *b = s_buffers.load(); b != NULL; b = b->next)
+        b->written = b->count.load(std::memory_order_acquire);
+    
+    s_enabled.store(true);
+    
+    return true;
+}
+
+// Enable tracing if LUMA_TRACE specifies an output file
+bool LumaTrace::startFromEnv()
+{
+    return start(getenv("LUMA_TRACE"));
+}
+
+LumaTrace::Buffer *LumaTrace::threadBuffer()
+{
+    static thread_local Buffer *buffer = NULL;
+    
+    if (buffer == NULL)
+    {
+        buffer = new Buffer(++s_threads);
+        
+        // Lock-free push to the list of thread buffers
+        Buffer *head = s_buffers.load();
+        do
+            buffer->next = head;
+        while (!s_buffers.compare_exchange_weak(head, buffer));
+    }
+    
+    return buffer;
+}
+
+void LumaTrace::record(const char *name, char phase, int64_t frame)
+{
+    Buffer *buffer = threadBuffer();
+    size_t n = buffer->count.load(std::memory_order_relaxed);
+    
+    // Events are dropped when the chunk table is full
+    const size_t c = n / TRACE_CHUNK_SIZE;
+    if (c >= TRACE_MAX_CHUNKS)
+        return;
+    if (buffer->chunks[c] == NULL)
+    {
+        Event *chunk = (Event*)malloc(TRACE_CHUNK_SIZE*sizeof(Event));
+        if (chunk == NULL)
+            return;
+        buffer->chunks[c] = chunk;
+    }
+    
+    Event &e = buffer->chunks[c][n % TRACE_CHUNK_SIZE];
+    e.name = name;
+    e.ts = lumaTimeNs();
+    e.frame = frame;
+    e.phase = phase;
+    
+    buffer->count.store(n+1, std::memory_order_release);
+}
+
+// Disable tracing, and write the recorded events. Threads that are still 
+// recording are safe, and only the events published so far are written
+void LumaTrace::stop()
+{
+    if (!s_enabled.exchange(false))
+        return;
+    
+    FILE *fp = fopen(s_outputFile.c_str(), "w");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Unable to open trace file '%s'\n", s_outputFile.c_str());
+        return;
+    }
+    
+    // Timestamps relative to the first event
+    uint64_t t0 = UINT64_MAX;
+    for (Buffer *b = s_buffers.load(); b != NULL; b = b->next)
+        if (b->count.load(std::memory_order_acquire) > b->written)
+            t0 = std::min(t0, b->chunks[b->written / TRACE_CHUNK_SIZE][b->written % TRACE_CHUNK_SIZE].ts);
+    
+    fprintf(fp, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (Buffer *b = s_buffers.load(); b != NULL; b = b->next)
+    {
+        size_t n = b->count.load(std::memory_order_acquire);
+        
+        fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}", 
+                first ? "" : ",\n", b->tid, b->tid);
+        first = false;
+        
+        for (size_t i=b->written; i<n; i++)
+        {
+            const Event &e = b->chunks[i / TRACE_CHUNK_SIZE][i % TRACE_CHUNK_SIZE];
+            fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u", 
+                    e.name, e.phase, 1e-3*(e.ts - t0), b->tid);
+            if (e.frame >= 0)
+                fprintf(fp, ",\"args\":{\"frame\":%lld}", (long long)e.frame);
+            fprintf(fp, "}");
+        }
+        
+        // The owning thread may still be recording, so only the writer's 
+        // position is updated
+        b->written = n;
+    }
+    fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(fp);
+}
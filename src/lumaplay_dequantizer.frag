@@ -42,7 +42,7 @@ uniform sampler2D texC1, texC2, texC3;
 uniform sampler1D texM;
 uniform float maxVal, maxValColor, exposure, gamma, scaling, strideRatio;
 
-uniform int colorSpaces[4], colorSpace, doTmo, ldrSim;
+uniform int colorSpaces[4], colorSpace, doTmo, ldrSim, linear;
 
 const mat3 xyz2rgb = mat3( 3.240708, -0.969257,  0.055636,
                           -1.537259,  1.875995, -0.203996,
@@ -147,6 +147,13 @@ void main (void)
     else
         RGB = RGB*exposure/scaling;
     
+    // Linear output, to a float framebuffer
+    if (linear > 0)
+    {
+        gl_FragColor = vec4(RGB, 1.0);
+        return;
+    }
+    
     if (doTmo > 0)
     {
         float n = 0.8, sig = 0.8;
@@ -38,6 +38,7 @@
 
 #include "mkv_interface.h"
 #include "luma_exception.h"
+#include "luma_trace.h"
 
 MkvInterface::MkvInterface()
 {
@@ -46,6 +47,7 @@ MkvInterface::MkvInterface()
     m_frameDuration = 40.0f;
     m_duration = 0.0f;
     m_file = NULL;
+    m_ownFile = m_seekable = true;
     m_currentTime = 0;
     
     m_attachments = NULL;
@@ -53,7 +55,11 @@ MkvInterface::MkvInterface()
     m_metaSeek = NULL;
     m_dummy = NULL;
     m_cluster = NULL;
-    m_blockGroup = m_blockGroupPrev = NULL;
+    m_blockGroup = m_blockGroupPrev = m_cueBlockGroup = NULL;
+    m_clusterBytes = 0;
+    m_clusterTimecode = 0.0f;
+    m_maxClusterBytes = 5 << 20;
+    m_maxClusterDuration = 5000.0f;
     
     m_upperElementa = m_upperElementb = 0;
     m_allowDummy = true;
@@ -61,17 +67,28 @@ MkvInterface::MkvInterface()
     m_element0 = m_element1 = m_element2a = m_element2b = m_element3a = m_element3b = m_element4a = m_element4b = NULL;
     
     m_trackNr = m_trackUID = -1;
+    m_width = m_height = 0;
     m_filePosition = m_elementPosition = 0;
     
     m_timecode = 0;
     
-    m_verbose = 0;
+    m_verbose = m_quiet = 0;
 }
 
 MkvInterface::~MkvInterface()
 {
+    // A failure to finish the output is not reported from the destructor
     if (m_file != NULL)
-        close();
+    {
+        try
+        {
+            close();
+        }
+        catch (...)
+        {
+            abandon();
+        }
+    }
     
     if (aStream != NULL)
         delete aStream;
@@ -85,6 +102,35 @@ MkvInterface::~MkvInterface()
 void MkvInterface::openWrite(const char *outputFile, 
                              const unsigned int w, const unsigned int h, 
                              const float maxL, const float minL)
+{
+    try
+    {
+        m_file = new StdIOCallback(outputFile, MODE_CREATE);
+    }
+    catch (std::exception & e)
+    {
+        throw LumaException(e.what());
+    }
+    m_ownFile = m_seekable = true;
+    
+    writeHead(w, h, maxL, minL, outputFile);
+}
+
+// Write to memory or a user callback. If the output is not seekable, the
+// segment size, duration and seek head are not updated on close
+void MkvInterface::openWrite(IOCallback *output, 
+                             const unsigned int w, const unsigned int h, 
+                             const float maxL, const float minL, bool seekable)
+{
+    m_file = output;
+    m_ownFile = false;
+    m_seekable = seekable;
+    
+    writeHead(w, h, maxL, minL, NULL);
+}
+
+void MkvInterface::writeHead(const unsigned int w, const unsigned int h, 
+                             const float maxL, const float minL, const char *outputFile)
 {
     m_writeMode = 1;
     
@@ -92,8 +138,6 @@ void MkvInterface::openWrite(const char *outputFile,
     {
         m_metaSeek = &GetChild<KaxSeekHead>(m_fileSegment);
         
-        m_file = new StdIOCallback(outputFile, MODE_CREATE);
-
         // EBML head
         EbmlHead FileHead;
         *static_cast<EbmlUInteger *>(&GetChild<EVersion>(FileHead)) = 1;
@@ -122,8 +166,11 @@ void MkvInterface::openWrite(const char *outputFile,
         *static_cast<EbmlUInteger *>(&GetChild<KaxTimecodeScale>(MyInfos)) = TIMECODE_SCALE;
         *static_cast<EbmlFloat *>(&GetChild<KaxDuration>(MyInfos)) = 1000.0;
         UTFstring str;
-        str.SetUTF8(outputFile);
-        *static_cast<EbmlUnicodeString *>(&GetChild<KaxSegmentFilename>(MyInfos)) = str.c_str();
+        if (outputFile != NULL)
+        {
+            str.SetUTF8(outputFile);
+            *static_cast<EbmlUnicodeString *>(&GetChild<KaxSegmentFilename>(MyInfos)) = str.c_str();
+        }
         
         str.SetUTF8(std::string("libebml v") + EbmlCodeVersion + std::string(" + libmatroska v") + KaxCodeVersion);
         *static_cast<EbmlUnicodeString *>(&GetChild<KaxMuxingApp>(MyInfos))  = str.c_str();
@@ -188,21 +235,46 @@ void MkvInterface::openWrite(const char *outputFile,
     }
     catch (std::exception & e)
     {
+        abandon();
         throw LumaException(e.what());
     } 
 
 }
 
 void MkvInterface::openRead(const char *inputFile)
+{
+    try
+    {
+        m_file = new StdIOCallback(inputFile, MODE_READ);
+    }
+    catch (std::exception &e)
+    {
+        throw LumaException(e.what());
+    }
+    m_ownFile = m_seekable = true;
+    
+    readHead(inputFile);
+}
+
+// Read from memory, or another user provided input
+void MkvInterface::openRead(IOCallback *input)
+{
+    m_file = input;
+    m_ownFile = false;
+    m_seekable = true;
+    
+    readHead("<memory>");
+}
+
+void MkvInterface::readHead(const char *inputName)
 {
     m_writeMode = 0;
     
-    fprintf(stderr, "\nReading '%s':\n", inputFile);
+    fprintf(stderr, "\nReading '%s':\n", inputName);
     fprintf(stderr, "---------------------------------------------------\n");
     
     try
     {
-        m_file = new StdIOCallback(inputFile, MODE_READ);
         aStream = new EbmlStream(*m_file);
 
         // find the EBML head in the file
@@ -225,7 +297,141 @@ void MkvInterface::openRead(const char *inputFile)
     fprintf(stderr, "---------------------------------------------------\n");
 }
 
+// Read the segment information, tracks and attachments at the beginning of
+// the file, the duration of the first frame, and the cues at the end of the
+// file, which are located through the seek head. No other clusters are read
+bool MkvInterface::probe(const char *inputFile)
+{
+    try
+    {
+        m_file = new StdIOCallback(inputFile, MODE_READ);
+    }
+    catch (std::exception &e)
+    {
+        throw LumaException(e.what());
+    }
+    m_ownFile = m_seekable = true;
+    m_writeMode = 0;
+    m_quiet = true;
+
+    try
+    {
+        aStream = new EbmlStream(*m_file);
+
+        m_element0 = aStream->FindNextID(EbmlHead::ClassInfos, 0xFFFFFFFFL);
+        if (m_element0 == NULL)
+            return false;
+        m_element0->SkipData(*aStream, EbmlHead_Context);
+        delete m_element0;
+
+        m_element0 = aStream->FindNextID(KaxSegment::ClassInfos, 0xFFFFFFFFL);
+        if (m_element0 == NULL)
+            return false;
+        const uint64 segmentStart = m_element0->GetElementPosition() + m_element0->HeadSize();
+        m_cuePosition = 0;
+
+        // Info, Tracks and Attachments precede the first cluster
+        if (!findCluster())
+            return m_trackNr >= 0;
+
+        // The block duration of the first block group, without reading the block
+        if (findBlockGroup())
+        {
+            int upper = 0;
+            EbmlElement *element;
+            while ((element = aStream->FindNextElement(m_element2b->Generic().Context, upper, 0xFFFFFFFFL, m_allowDummy)) != NULL)
+            {
+                if (upper != 0)
+                {
+                    delete element;
+                    break;
+                }
+
+                if (EbmlId(*element) == KaxBlockDuration::ClassInfos.GlobalId)
+                {
+                    KaxBlockDuration *BlockDuration = static_cast<KaxBlockDuration*>(element);
+                    BlockDuration->ReadData(aStream->I_O());
+                    m_frameDuration = uint32(*BlockDuration);
+                }
+                element->SkipData(*aStream, element->Generic().Context);
+                delete element;
+            }
+            delete m_element2b;
+            m_element2b = NULL;
+        }
+
+        // Skip all clusters, to the cues
+        if (m_cuePosition > 0)
+        {
+            m_file->setFilePointer(segmentStart + m_cuePosition, seek_beginning);
+            delete m_element1;
+            m_element1 = NULL;
+            m_upperElementa = 0;
+            findCluster();
+        }
+    }
+    catch (std::exception &e)
+    {
+        throw LumaException(e.what());
+    }
+
+    return m_trackNr >= 0;
+}
+
 void MkvInterface::close()
+{
+    try
+    {
+        finishWrite();
+    }
+    catch (...)
+    {
+        abandon();
+        throw;
+    }
+    
+    if (m_file != NULL && m_ownFile)
+    {
+        m_file->close();
+        delete m_file;
+    }
+    m_file = NULL;
+}
+
+// Stop writing after a failed write. The output is released without writing
+// anything more to it, and the frames that were not written are dropped
+void MkvInterface::abandon()
+{
+    if (m_file != NULL && m_ownFile)
+    {
+        try
+        {
+            m_file->close();
+        }
+        catch (...)
+        {}
+        delete m_file;
+    }
+    m_file = NULL;
+    
+    // The cue of the cluster that was not written has to be resolved, as the
+    // cues do not allow pending references when they are deleted
+    if (m_cueBlockGroup != NULL && m_cues != NULL)
+        m_cues->PositionSet(*m_cueBlockGroup);
+    if (m_cluster != NULL)
+        m_cluster->ReleaseFrames();
+    while (!m_frameBuffer.empty())
+    {
+        delete[] m_frameBuffer.back();
+        m_frameBuffer.pop_back();
+    }
+    m_cluster = NULL;
+    m_blockGroup = m_cueBlockGroup = NULL;
+    m_clusterBytes = 0;
+}
+
+// Write the last cluster, cues, and the updated head of the output
+void MkvInterface::finishWrite()
 {
     flushCluster();
     
@@ -237,6 +443,11 @@ void MkvInterface::close()
             m_metaSeek->IndexThis(*m_cues, m_fileSegment);
         }
         
+    }
+    
+    // Update duration, seek head and segment size, at the beginning of the file
+    if (m_file != NULL && m_writeMode && m_seekable)
+    {
         KaxInfo & MyInfos = GetChild<KaxInfo>(m_fileSegment);
 
         KaxDuration &Duration = GetChild<KaxDuration>(MyInfos);
@@ -258,13 +469,6 @@ void MkvInterface::close()
                                     m_fileSegment.HeadSize()))
             m_fileSegment.OverwriteHead(*m_file);
     }
-    
-    if (m_file != NULL)
-    {
-        m_file->close();
-        delete m_file;
-    }
-    m_file = NULL;
 }
 
 void MkvInterface::addAttachment(unsigned int uid, const binary* buffer, unsigned int buffer_size, const char* description)
@@ -313,7 +517,15 @@ void MkvInterface::writeAttachments()
 {
     if (m_attachments != NULL)
     {
-        m_attachments->Render(*m_file, m_writeDefaultValues);
+        try
+        {
+            m_attachments->Render(*m_file, m_writeDefaultValues);
+        }
+        catch (...)
+        {
+            abandon();
+            throw;
+        }
         m_metaSeek->IndexThis(*m_attachments, m_fileSegment);
     }
 }
@@ -330,13 +542,29 @@ bool MkvInterface::getAttachment(unsigned int ind, binary** buffer, unsigned int
     return 1;
 }
 
+void MkvInterface::setClusterLimits(size_t maxBytes, float maxDuration)
+{
+    m_maxClusterBytes = maxBytes;
+    m_maxClusterDuration = 1000.0f*maxDuration;
+}
+
 void MkvInterface::addFrame(const uint8 *frame_buffer, unsigned int buffer_size, bool isKey)
 {
+    if (m_file == NULL)
+        throw LumaException("Output is closed, or a previous write failed");
+    
     m_timecode = m_frameDuration * m_frameCount;
     if (m_verbose) fprintf(stderr, "Frame %d (%f)\n", m_frameCount+1, m_timecode);
     
-    // switch to new cluster for every key frame
-    if (isKey)
+    // Switch to a new cluster for every key frame, and when the cluster would
+    // exceed the size or duration limits. The timecodes of the blocks are
+    // relative to the cluster, as 16 bit integers, which also limits the
+    // duration of a cluster to 32 s
+    const float duration = m_timecode - m_clusterTimecode;
+    if (isKey || m_cluster == NULL ||
+        (m_maxClusterBytes > 0 && m_clusterBytes > 0 && m_clusterBytes + buffer_size > m_maxClusterBytes) ||
+        (m_maxClusterDuration > 0.0f && duration >= m_maxClusterDuration) ||
+        duration + m_frameDuration > 32000.0f)
     {
         flushCluster();
         
@@ -350,8 +578,14 @@ void MkvInterface::addFrame(const uint8 *frame_buffer, unsigned int buffer_size,
         
         KaxClusterTimecode & MyClusterTimeCode = GetChild<KaxClusterTimecode>(*m_cluster);
 		*(static_cast<EbmlUInteger *>(&MyClusterTimeCode)) = m_timecode;// * m_timecodeScale;
+        
+        m_clusterTimecode = m_timecode;
     }
     
+    // A key frame starts a new group of frames, which reference it
+    if (isKey)
+        m_blockGroupPrev = NULL;
+    
     // for each frame, create new block group in current cluster
     m_blockGroup = &m_cluster->GetNewBlock();		
     m_blockGroup->SetParent(*m_cluster);
@@ -362,20 +596,22 @@ void MkvInterface::addFrame(const uint8 *frame_buffer, unsigned int buffer_size,
     memcpy((void*)fb, (void*)frame_buffer, buffer_size);
     DataBuffer *data = new DataBuffer((binary *)fb, buffer_size);
     m_frameBuffer.push_back(fb);
+    m_clusterBytes += buffer_size;
     
     //KaxBlock &MyKaxBlock = GetChild<KaxBlock>(*m_blockGroup);
 	//MyKaxBlock.SetParent(*m_cluster);	
     
-    // frame without reference (key/I frame)
+    // frame without reference (key/I frame), which is added to the cues
     if (m_blockGroupPrev == NULL)
     {
         if (m_verbose) fprintf(stderr, "\tKey frame (I)\n");
         //MyKaxBlock.AddFrame(*m_track, m_timecode * TIMECODE_SCALE, *data, LACING_AUTO);
         m_blockGroup->AddFrame(*m_track, m_timecode * TIMECODE_SCALE, *data, LACING_AUTO);
         
-        m_blockGroupPrev = m_blockGroup;
+        m_blockGroupPrev = m_cueBlockGroup = m_blockGroup;
     }
-    // frame with reference to last key frame (P frame)
+    // frame with reference to last key frame (P frame), which can be in a
+    // previous cluster
     else
     {
         if (m_verbose) fprintf(stderr, "\tIntermediate frame (P)\n");
@@ -397,16 +633,27 @@ void MkvInterface::addFrame(const uint8 *frame_buffer, unsigned int buffer_size,
 
 void MkvInterface::flushCluster()
 {
-    if (m_blockGroupPrev != NULL)
+    LumaTraceScope trace("flush_cluster");
+    
+    // Only clusters that start with a key frame are added to the cues
+    if (m_cueBlockGroup != NULL)
     {
         KaxBlockBlob *Blob = new KaxBlockBlob(BLOCK_BLOB_NO_SIMPLE);
-        Blob->SetBlockGroup(*m_blockGroupPrev);
+        Blob->SetBlockGroup(*m_cueBlockGroup);
         m_cues->AddBlockBlob(*Blob);
     }
 
     if (m_cluster != NULL)
     {
-        m_cluster->Render(*m_file, *m_cues, m_writeDefaultValues);
+        try
+        {
+            m_cluster->Render(*m_file, *m_cues, m_writeDefaultValues);
+        }
+        catch (...)
+        {
+            abandon();
+            throw;
+        }
         m_cluster->ReleaseFrames();
         
         while (!m_frameBuffer.empty())
@@ -423,11 +670,14 @@ void MkvInterface::flushCluster()
         
         // cluster deletion seems to be handled automatically when using reference frames
         // TODO: is this true, or is this a potential memory leak?
+        // The block groups of a cluster are referenced from the following
+        // clusters of the same group of frames, and need to be kept
         //delete m_cluster;
     }
     
     m_cluster = NULL;
-    m_blockGroup = m_blockGroupPrev = NULL;
+    m_blockGroup = m_cueBlockGroup = NULL;
+    m_clusterBytes = 0;
 }
 
 bool MkvInterface::readFrame()
@@ -494,18 +744,18 @@ bool MkvInterface::findCluster()
 
         if (EbmlId(*m_element1) == KaxInfo::ClassInfos.GlobalId)
         {
-            fprintf(stderr, "File info:\n");
+            if (!m_quiet) fprintf(stderr, "File info:\n");
             handleInfo();
         }
         else if (EbmlId(*m_element1) == KaxTracks::ClassInfos.GlobalId)
         {
             // found the Tracks element
-            fprintf(stderr, "Segment Tracks:\n");
+            if (!m_quiet) fprintf(stderr, "Segment Tracks:\n");
             handleTracksData();
         }
         else if (EbmlId(*m_element1) == KaxAttachments::ClassInfos.GlobalId)
         {
-            fprintf(stderr, "Attachments:\n");
+            if (!m_quiet) fprintf(stderr, "Attachments:\n");
             handleAttachments();
         }
         else if (EbmlId(*m_element1) == KaxCues::ClassInfos.GlobalId)
@@ -702,6 +952,7 @@ void MkvInterface::handleTracksData()
             
             bool videoTrackFound = false;
             int trackNr = -1, trackUID = -1;
+            unsigned int width = 0, height = 0;
             
             while (m_element3a != NULL)
             {
@@ -717,7 +968,7 @@ void MkvInterface::handleTracksData()
                     KaxTrackNumber & TrackNum = *static_cast<KaxTrackNumber*>(m_element3a);
                     TrackNum.ReadData(aStream->I_O());
                     trackNr = uint8(TrackNum);
-                    fprintf(stderr, "\tTrack # %d\n", trackNr);
+                    if (!m_quiet) fprintf(stderr, "\tTrack # %d\n", trackNr);
                 }
                 
                 // Track type
@@ -725,67 +976,69 @@ void MkvInterface::handleTracksData()
                 {
                     KaxTrackType & TrackType = *static_cast<KaxTrackType*>(m_element3a);
                     TrackType.ReadData(aStream->I_O());
-                    fprintf(stderr, "\tTrack type : ");
+                    if (!m_quiet) fprintf(stderr, "\tTrack type : ");
                     switch(uint8(TrackType))
                     {
                         case track_audio:
-                            fprintf(stderr, "Audio");
+                            if (!m_quiet) fprintf(stderr, "Audio");
                             break;
                         case track_video:
-                            fprintf(stderr, "Video");
+                            if (!m_quiet) fprintf(stderr, "Video");
                             videoTrackFound = true;
                             break;
                         default:
-                            fprintf(stderr, "unknown");
+                            if (!m_quiet) fprintf(stderr, "unknown");
                     }
-                    fprintf(stderr, "\n");
+                    if (!m_quiet) fprintf(stderr, "\n");
                 }
 
                 else if (EbmlId(*m_element3a) == KaxTrackFlagLacing::ClassInfos.GlobalId)
                 {
-                    fprintf(stderr, "\tFlag Lacing\n");
+                    if (!m_quiet) fprintf(stderr, "\tFlag Lacing\n");
                 }
                 else if (EbmlId(*m_element3a) == KaxCodecID::ClassInfos.GlobalId)
                 {
                     KaxCodecID & CodecID = *static_cast<KaxCodecID*>(m_element3a);
                     CodecID.ReadData(aStream->I_O());
-                    fprintf(stderr, "\tCodec ID   : %s\n", std::string(CodecID).c_str());
+                    if (!m_quiet) fprintf(stderr, "\tCodec ID   : %s\n", std::string(CodecID).c_str());
                 }
                 else if (EbmlId(*m_element3a) == KaxTrackUID::ClassInfos.GlobalId)
                 {
                     KaxTrackUID & TrackUID = *static_cast<KaxTrackUID*>(m_element3a);
                     TrackUID.ReadData(aStream->I_O());
                     trackUID = (unsigned int)TrackUID;
-                    fprintf(stderr, "\tTrack UID   : %d\n", trackUID);
+                    if (!m_quiet) fprintf(stderr, "\tTrack UID   : %d\n", trackUID);
                 }
                 else if (EbmlId(*m_element3a) == KaxTrackVideo::ClassInfos.GlobalId)
                 {
                     KaxTrackVideo & TrackVideo = *static_cast<KaxTrackVideo*>(m_element3a);
+                    int upperElement = 0;
+                    EbmlElement *found = NULL;
+                    TrackVideo.Read(*aStream, KaxTrackVideo::ClassInfos.Context, upperElement, found, m_allowDummy);
+                    delete found;
                     for (unsigned int j = 0; j<TrackVideo.ListSize(); j++)
                     {
                         if (EbmlId(*TrackVideo[j]) == KaxVideoFlagInterlaced::ClassInfos.GlobalId) 
                         {
 	                        KaxVideoFlagInterlaced &Interlaced = *static_cast<KaxVideoFlagInterlaced*>(TrackVideo[j]);
-	                        Interlaced.ReadData(aStream->I_O());
-	                        fprintf(stderr, "\tInterlaced : %d\n", (unsigned int)Interlaced);
+	                        if (!m_quiet) fprintf(stderr, "\tInterlaced : %d\n", (unsigned int)Interlaced);
                         }
                         else if (EbmlId(*TrackVideo[j]) == KaxVideoPixelWidth::ClassInfos.GlobalId)
                         {
 	                        KaxVideoPixelWidth &PixelWidth = *static_cast<KaxVideoPixelWidth*>(TrackVideo[j]);
-	                        PixelWidth.ReadData(aStream->I_O());
-	                        fprintf(stderr, "\tPixelWidth : %d\n", (unsigned int)PixelWidth);
+	                        width = (unsigned int)PixelWidth;
+	                        if (!m_quiet) fprintf(stderr, "\tPixelWidth : %d\n", (unsigned int)PixelWidth);
                         }
                         else if (EbmlId(*TrackVideo[j]) == KaxVideoPixelHeight::ClassInfos.GlobalId)
                         {
 	                        KaxVideoPixelHeight &PixelHeight = *static_cast<KaxVideoPixelHeight*>(TrackVideo[j]);
-	                        PixelHeight.ReadData(aStream->I_O());
-	                        fprintf(stderr, "\tPixelHeight : %d\n", (unsigned int)PixelHeight);
+	                        height = (unsigned int)PixelHeight;
+	                        if (!m_quiet) fprintf(stderr, "\tPixelHeight : %d\n", (unsigned int)PixelHeight);
                         }
                         else if (EbmlId(*TrackVideo[j]) == KaxVideoFrameRate::ClassInfos.GlobalId)
                         {
 	                        KaxVideoFrameRate &FrameRate = *static_cast<KaxVideoFrameRate*>(TrackVideo[j]);
-	                        FrameRate.ReadData(aStream->I_O());
-	                        fprintf(stderr, "\tFrameRate : %f\n", (float)FrameRate);
+	                        if (!m_quiet) fprintf(stderr, "\tFrameRate : %f\n", (float)FrameRate);
                         }				
                     }
                 }
@@ -800,6 +1053,8 @@ void MkvInterface::handleTracksData()
             {
                 m_trackNr = trackNr;
                 m_trackUID = trackUID;
+                m_width = width;
+                m_height = height;
             }
         }
         if (m_upperElementa > 0)
@@ -818,7 +1073,7 @@ void MkvInterface::handleTracksData()
             m_element2a = aStream->FindNextElement(m_element1->Generic().Context, m_upperElementa, 0xFFFFFFFFL, m_allowDummy);
         }
     }
-    fprintf(stderr, "\n");
+    if (!m_quiet) fprintf(stderr, "\n");
 }
 
 void MkvInterface::handleAttachments()
@@ -892,7 +1147,7 @@ void MkvInterface::handleAttachments()
                 m_element3a = aStream->FindNextElement(m_element2a->Generic().Context, m_upperElementa, 0xFFFFFFFFL, m_allowDummy);
             }
             
-            fprintf(stderr, "\t%s (UID:%d) : %s\n", attName.c_str(), m_attachmentID.back(), attDesc.c_str());
+            if (!m_quiet) fprintf(stderr, "\t%s (UID:%d) : %s\n", attName.c_str(), m_attachmentID.back(), attDesc.c_str());
         }
         if (m_upperElementa > 0)
         {
@@ -980,40 +1235,40 @@ void MkvInterface::handleInfo()
         {
             KaxTimecodeScale *TimeScale = static_cast<KaxTimecodeScale*>(m_element2a);
             TimeScale->ReadData(aStream->I_O());
-            fprintf(stderr, "\tTimecode Scale : %d\n", uint32(*TimeScale));
+            if (!m_quiet) fprintf(stderr, "\tTimecode Scale : %d\n", uint32(*TimeScale));
         }
         else if (EbmlId(*m_element2a) == KaxDuration::ClassInfos.GlobalId)
         {
             KaxDuration *Duration = static_cast<KaxDuration*>(m_element2a);
             Duration->ReadData(aStream->I_O());
             m_duration = Duration->GetValue();
-            fprintf(stderr, "\tSegment duration : %0.2fs\n", 1000*m_duration/TIMECODE_SCALE);
+            if (!m_quiet) fprintf(stderr, "\tSegment duration : %0.2fs\n", 1000*m_duration/TIMECODE_SCALE);
         }
         else if (EbmlId(*m_element2a) == KaxDateUTC::ClassInfos.GlobalId)
         {
-            fprintf(stderr, "\tDate UTC\n");
+            if (!m_quiet) fprintf(stderr, "\tDate UTC\n");
         }
         else if (EbmlId(*m_element2a) == KaxSegmentFilename::ClassInfos.GlobalId)
         {
             KaxSegmentFilename *fn = static_cast<KaxSegmentFilename*>(m_element2a);
             fn->ReadData(aStream->I_O());
-            fprintf(stderr, "\tSegment filename : %s\n", UTFstring(*fn).GetUTF8().c_str());
+            if (!m_quiet) fprintf(stderr, "\tSegment filename : %s\n", UTFstring(*fn).GetUTF8().c_str());
         }
         else if (EbmlId(*m_element2a) == KaxMuxingApp::ClassInfos.GlobalId)
         {
             KaxMuxingApp *pApp = static_cast<KaxMuxingApp*>(m_element2a);
             pApp->ReadData(aStream->I_O());
-            fprintf(stderr, "\tMuxing app : %s\n", UTFstring(*pApp).GetUTF8().c_str());
+            if (!m_quiet) fprintf(stderr, "\tMuxing app : %s\n", UTFstring(*pApp).GetUTF8().c_str());
         }
         else if (EbmlId(*m_element2a) == KaxWritingApp::ClassInfos.GlobalId)
         {
             KaxWritingApp *pApp = static_cast<KaxWritingApp*>(m_element2a);
             pApp->ReadData(aStream->I_O());
-            fprintf(stderr, "\tWriting app : %s\n", UTFstring(*pApp).GetUTF8().c_str());
+            if (!m_quiet) fprintf(stderr, "\tWriting app : %s\n", UTFstring(*pApp).GetUTF8().c_str());
         }
         else
         {
-            fprintf(stderr, "\tOther...\n");
+            if (!m_quiet) fprintf(stderr, "\tOther...\n");
         }
         
         if (m_upperElementa > 0)
@@ -1032,7 +1287,7 @@ void MkvInterface::handleInfo()
             m_element2a = aStream->FindNextElement(m_element1->Generic().Context, m_upperElementa, 0xFFFFFFFFL, m_allowDummy);
         }
     }
-    fprintf(stderr, "\n");
+    if (!m_quiet) fprintf(stderr, "\n");
 }
 
 void MkvInterface::handleCueData()
@@ -1092,7 +1347,7 @@ void MkvInterface::handleCueData()
                         else if (CuePos[Index2]->Generic().GlobalId == KaxCueReference::ClassInfos.GlobalId)
                         {
                             KaxCueReference & CueRefs = *static_cast<KaxCueReference *>(CuePos[Index2]);
-                            fprintf(stderr, "\t\t\tReference\n");
+                            if (m_verbose) fprintf(stderr, "\t\t\tReference\n");
 
                             unsigned int Index3;
                             for (Index3 = 0; Index3<CueRefs.ListSize() ;Index3++)
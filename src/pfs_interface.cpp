@@ -90,10 +90,7 @@ bool PfsInterface::readFrame(const char *inputFile, LumaFrame &frame)
       throw LumaException( "Missing X, Y, Z channels in the PFS stream" );
   
   
-    frame.width = pfs_frame->getWidth();  
-    frame.height = pfs_frame->getHeight();
-    frame.channels = 3;
-    if (!frame.init())
+    if (!frame.resize(pfs_frame->getWidth(), pfs_frame->getHeight(), 3))
       throw LumaException( "Cannot allocate memory for frame" );
 
     memcpy( frame.getChannel(0), R->getRawData(), frame.height*frame.width*sizeof(float) );
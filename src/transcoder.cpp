@@ -0,0 +1,193 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#include "transcoder.h"
+#include "luma_exception.h"
+#include "luma_trace.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <thread>
+
+Transcoder::Transcoder(unsigned int queueSize) :
+    m_first(0), m_queueSize(std::max(queueSize, 1u)), m_active(0), m_decoded(0), m_finished(false),
+    m_pool(m_queueSize + 1)
+{}
+
+// Release the frames at the front of the queue that all encoders are done with
+void Transcoder::done(size_t ind)
+{
+    if (--m_queue[ind - m_first].pending)
+        return;
+    
+    while (m_queue.size() && !m_queue.front().pending)
+    {
+        m_pool.release(std::move(m_queue.front().frame));
+        m_queue.pop_front();
+        m_first++;
+    }
+    m_slotAvailable.notify_one();
+}
+
+bool Transcoder::run(LumaDecoder &decoder, unsigned int maxFrames, bool verbose)
+{
+    if (!m_renditions.size())
+        throw LumaException("No renditions to transcode to");
+    
+    m_queue.clear();
+    m_first = 0;
+    m_decoded = 0;
+    m_finished = false;
+    m_active = (unsigned int)m_renditions.size();
+    
+    std::vector<std::thread> threads;
+    for (size_t i=0; i<m_renditions.size(); i++)
+        threads.push_back(std::thread(&Transcoder::encode, this, std::ref(m_renditions[i])));
+    
+    std::string error;
+    try
+    {
+        LumaFrame *frame;
+        while ((!maxFrames || m_decoded < maxFrames) && (frame = decoder.decode()) != NULL)
+        {
+            // The decoded buffer is handed to the encoders, and the decoder
+            // continues with a recycled buffer
+            LumaFrame shared = m_pool.acquire(frame->width, frame->height, frame->channels);
+            shared.swap(*frame);
+            
+            std::unique_lock<std::mutex> lock(m_mutex);
+            LumaTrace::begin("wait_slot", m_decoded);
+            while (m_active && m_queue.size() >= m_queueSize)
+                m_slotAvailable.wait(lock);
+            LumaTrace::end("wait_slot");
+            
+            // Stop decoding if all encoders have failed
+            if (!m_active)
+                break;
+            
+            SharedFrame entry = { std::move(shared), m_active };
+            m_queue.push_back(std::move(entry));
+            m_decoded++;
+            m_frameReady.notify_all();
+            
+            if (verbose)
+                fprintf(stderr, "Decoded frame %u (queue: %lu)\n", m_decoded, (unsigned long)m_queue.size());
+        }
+    }
+    catch (std::exception &e)
+    {
+        error = e.what();
+    }
+    
+    // The encoders finish the frames in the queue, also if the decoding failed,
+    // so that the outputs are valid videos of the frames decoded so far
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_finished = true;
+        m_frameReady.notify_all();
+    }
+    for (size_t i=0; i<threads.size(); i++)
+        threads[i].join();
+    
+    m_queue.clear();
+    m_pool.clear();
+    
+    if (error.size())
+        throw LumaException(("Decoding failed: " + error).c_str());
+    
+    for (size_t i=0; i<m_renditions.size(); i++)
+        if (m_renditions[i].failed)
+            return false;
+    
+    return true;
+}
+
+void Transcoder::encode(Rendition &rendition)
+{
+    LumaTraceScope trace("rendition");
+    uint64_t start = lumaTimeNs();
+    
+    LumaEncoder encoder;
+    encoder.setParams(rendition.params);
+    
+    size_t ind = 0;
+    try
+    {
+        while (1)
+        {
+            const LumaFrame *frame;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                while (!m_finished && ind >= m_first + m_queue.size())
+                    m_frameReady.wait(lock);
+                if (ind >= m_first + m_queue.size())
+                    break;
+                
+                // The frame stays in place until all encoders are done with it
+                frame = &m_queue[ind - m_first].frame;
+            }
+            
+            if (!encoder.initialized())
+                encoder.initialize(rendition.output.c_str(), frame->width, frame->height);
+            
+            encoder.encode(LumaImageView(frame->buffer, frame->width, frame->height));
+            rendition.frames++;
+            
+            std::unique_lock<std::mutex> lock(m_mutex);
+            done(ind++);
+        }
+        
+        if (encoder.initialized())
+            encoder.finish();
+    }
+    catch (std::exception &e)
+    {
+        rendition.failed = true;
+        rendition.error = e.what();
+        
+        // Let go of the frames that are left in the queue, and of the frames
+        // that will be decoded
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (; ind < m_first + m_queue.size(); ind++)
+            done(ind);
+        m_active--;
+        m_slotAvailable.notify_one();
+    }
+    
+    rendition.seconds = (lumaTimeNs() - start) * 1e-9;
+}
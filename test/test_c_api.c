@@ -0,0 +1,202 @@
+#include <luma_api.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#define WIDTH 128
+#define HEIGHT 96
+#define FRAMES 10
+
+/* Growable output buffer */
+typedef struct
+{
+    unsigned char *data;
+    size_t size, capacity;
+} buffer_t;
+
+static int writeBuffer(void *user, const void *data, size_t size)
+{
+    buffer_t *buf = (buffer_t*)user;
+    if (buf->size + size > buf->capacity)
+    {
+        size_t capacity = 2*(buf->size + size);
+        unsigned char *p = (unsigned char*)realloc(buf->data, capacity);
+        if (p == NULL)
+            return 0;
+        buf->data = p;
+        buf->capacity = capacity;
+    }
+    memcpy(buf->data + buf->size, data, size);
+    buf->size += size;
+    return 1;
+}
+
+/* Output that fails after the head of the stream, when writing frames */
+static int writeLimited(void *user, const void *data, size_t size)
+{
+    buffer_t *buf = (buffer_t*)user;
+    if (buf->size + size > 5000)
+        return 0;
+    return writeBuffer(user, data, size);
+}
+
+/* Test pattern in luminance 0.01-1e4 cd/m^2 */
+static float pattern(unsigned int x, unsigned int y, unsigned int c, unsigned int f)
+{
+    float l = powf(10.0f, -2.0f + 6.0f*((x + 2*f) % WIDTH)/WIDTH);
+    return l*(0.6f + 0.4f*sinf(0.1f*y + 2.0f*c));
+}
+
+/* Float to half, for the test pattern (normalized range only) */
+static uint16_t toHalf(float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(float));
+    return (uint16_t)(((bits >> 16) & 0x8000) | (((bits & 0x7fffffff) - 0x38000000 + 0x1000) >> 13));
+}
+
+int main(int argc, char* argv[])
+{
+    buffer_t output = { NULL, 0, 0 };
+    luma_enc_params_t params;
+    luma_encoder_t *enc;
+    luma_decoder_t *dec;
+    luma_image_t image;
+    unsigned int x, y, c, f, w, h, n = 0;
+    double err = 0.0;
+
+    /* Encoder input, as interleaved RGBA half with 16 bytes of row padding */
+    const size_t rowStride = WIDTH*4*sizeof(uint16_t) + 16;
+    uint16_t *input = (uint16_t*)malloc(HEIGHT*rowStride);
+
+    /* Decoder output, as planar float */
+    float *frame = (float*)malloc(WIDTH*HEIGHT*3*sizeof(float));
+
+    (void)argc; (void)argv;
+
+    if (luma_enc_api_version() != LUMA_API_VERSION || luma_dec_api_version() != LUMA_API_VERSION)
+    {
+        fprintf(stderr, "API version mismatch\n");
+        return 1;
+    }
+
+    /* Parameters that were not set up by luma_enc_params_init() are rejected */
+    memset(&params, 0, sizeof(params));
+    if (luma_enc_create_callback(writeBuffer, &output, WIDTH, HEIGHT, &params) != NULL)
+    {
+        fprintf(stderr, "Uninitialized parameters were accepted\n");
+        return 1;
+    }
+
+    luma_enc_params_init(&params);
+    params.ptf = LUMA_PTF_PQ;
+    params.color_space = LUMA_CS_LUV;
+
+    enc = luma_enc_create_callback(writeBuffer, &output, WIDTH, HEIGHT, &params);
+    if (enc == NULL)
+    {
+        fprintf(stderr, "Failed to create encoder: %s\n", luma_enc_last_error());
+        return 1;
+    }
+
+    luma_image_init(&image, input, WIDTH, HEIGHT, 4, LUMA_FLOAT16, LUMA_INTERLEAVED);
+    image.row_stride = rowStride;
+    for (f = 0; f < FRAMES; f++)
+    {
+        for (y = 0; y < HEIGHT; y++)
+        {
+            uint16_t *row = (uint16_t*)((char*)input + y*rowStride);
+            for (x = 0; x < WIDTH; x++)
+            {
+                for (c = 0; c < 3; c++)
+                    row[4*x+c] = toHalf(pattern(x, y, c, f));
+                row[4*x+3] = 0x3c00;
+            }
+        }
+
+        if (luma_enc_push_frame(enc, &image) != LUMA_OK)
+        {
+            fprintf(stderr, "Failed to encode frame: %s\n", luma_enc_last_error());
+            return 1;
+        }
+    }
+
+    /* Wrong frame size is rejected */
+    image.width = WIDTH/2;
+    if (luma_enc_push_frame(enc, &image) != LUMA_INVALID_ARGUMENT)
+    {
+        fprintf(stderr, "Invalid frame size was accepted\n");
+        return 1;
+    }
+
+    luma_enc_destroy(enc);
+    printf("Encoding finished. %u frames, %lu bytes.\n", FRAMES, (unsigned long)output.size);
+
+    dec = luma_dec_create_memory(output.data, output.size);
+    if (dec == NULL)
+    {
+        fprintf(stderr, "Failed to create decoder: %s\n", luma_dec_last_error());
+        return 1;
+    }
+
+    luma_dec_get_info(dec, &w, &h, NULL);
+    if (w != WIDTH || h != HEIGHT)
+    {
+        fprintf(stderr, "Wrong frame size %ux%u\n", w, h);
+        return 1;
+    }
+
+    luma_image_init(&image, frame, WIDTH, HEIGHT, 3, LUMA_FLOAT32, LUMA_PLANAR);
+    while (luma_dec_next_frame(dec, &image) == LUMA_OK)
+    {
+        for (c = 0; c < 3; c++)
+            for (y = 0; y < HEIGHT; y++)
+                for (x = 0; x < WIDTH; x++)
+                {
+                    float v = frame[(c*HEIGHT + y)*WIDTH + x];
+                    err += fabs(log10(v > 1e-4f ? v : 1e-4f) - log10(pattern(x, y, c, n)));
+                }
+        n++;
+    }
+    luma_dec_destroy(dec);
+    free(output.data);
+    free(frame);
+
+    /* A failing output is reported as an error, after which the encoder can
+       still be destroyed without writing to the output again */
+    output.data = NULL;
+    output.size = output.capacity = 0;
+    enc = luma_enc_create_callback(writeLimited, &output, WIDTH, HEIGHT, &params);
+    if (enc == NULL)
+    {
+        fprintf(stderr, "Failed to create encoder: %s\n", luma_enc_last_error());
+        return 1;
+    }
+    luma_image_init(&image, input, WIDTH, HEIGHT, 4, LUMA_FLOAT16, LUMA_INTERLEAVED);
+    image.row_stride = rowStride;
+    for (f = 0; f < FRAMES && luma_enc_push_frame(enc, &image) == LUMA_OK; f++)
+        ;
+    if (f == FRAMES && luma_enc_finish(enc) == LUMA_OK)
+    {
+        fprintf(stderr, "Failed write to the output was not reported\n");
+        return 1;
+    }
+    printf("Failing output reported: %s\n", luma_enc_last_error());
+    luma_enc_destroy(enc);
+    free(output.data);
+    free(input);
+
+    err /= (double)n*WIDTH*HEIGHT*3;
+    printf("Decoding finished. %u frames, mean log10 error %f.\n", n, err);
+
+    if (n != FRAMES || err > 0.1)
+    {
+        fprintf(stderr, "Round trip through the C API failed\n");
+        return 1;
+    }
+
+    return 0;
+}
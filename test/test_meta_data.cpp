@@ -0,0 +1,141 @@
+#include <luma_meta_data.h>
+#include <luma_exception.h>
+
+#include <stdio.h>
+#include <string.h>
+
+// Serialization of the meta data record, for all PTFs, and parsing of the
+// attachments of files written before the record. The delta coding of the
+// mapping has to be lossless
+int main()
+{
+    const LumaQuantizer::ptf_t ptfs[] = {LumaQuantizer::PTF_PSI, LumaQuantizer::PTF_PQ, LumaQuantizer::PTF_LOG,
+                                         LumaQuantizer::PTF_JND_HDRVDP, LumaQuantizer::PTF_LINEAR};
+    const unsigned int bitDepths[] = {8, 11, 12, 16};
+    unsigned int failed = 0;
+    
+    for (unsigned int p = 0; p < 5; p++)
+        for (unsigned int b = 0; b < 4; b++)
+        {
+            LumaQuantizer quant;
+            quant.setQuantizer(ptfs[p], bitDepths[b], LumaQuantizer::CS_YCBCR, 10, 1000.0f, 0.01f);
+            
+            LumaMetaData meta, res;
+            meta.ptf = ptfs[p];
+            meta.colorSpace = LumaQuantizer::CS_YCBCR;
+            meta.ptfBitDepth = bitDepths[b];
+            meta.colorBitDepth = 10;
+            meta.preScaling = 20.0f;
+            meta.maxLum = 1000.0f;
+            meta.minLum = 0.01f;
+            meta.mapping.assign(quant.getMapping(), quant.getMapping() + quant.getSize() + 1);
+            
+            std::vector<uint8_t> record;
+            meta.serialize(record);
+            
+            bool ok = res.deserialize(&record[0], record.size()) &&
+                      res.ptf == meta.ptf && res.colorSpace == meta.colorSpace &&
+                      res.ptfBitDepth == meta.ptfBitDepth && res.colorBitDepth == meta.colorBitDepth &&
+                      res.preScaling == meta.preScaling && res.maxLum == meta.maxLum && res.minLum == meta.minLum &&
+                      res.mapping == meta.mapping;
+            
+            // A truncated record, or a mapping of another size than the bit
+            // depth, is not valid
+            ok = ok && !res.deserialize(&record[0], record.size() - 1);
+            std::vector<uint8_t> resized = record;
+            resized[28]++;
+            ok = ok && !res.deserialize(&resized[0], resized.size());
+            
+            // Analytic mappings are not stored, as when encoding
+            std::vector<uint8_t> stored = record;
+            if (!LumaQuantizer::tabulated(ptfs[p]))
+            {
+                meta.mapping.clear();
+                meta.serialize(stored);
+                ok = ok && res.deserialize(&stored[0], stored.size()) && res.mapping.empty();
+            }
+            
+            printf("%-45s %2u bits: float %6u, delta %6u, stored %6u bytes %s\n", LumaQuantizer::name(ptfs[p]).c_str(), bitDepths[b],
+                   (unsigned int)(4*(quant.getSize() + 1)), (unsigned int)record.size(), (unsigned int)stored.size(), ok ? "ok" : "FAILED");
+            failed += !ok;
+        }
+    
+    // The header is little-endian, independent of the host
+    LumaMetaData meta;
+    meta.maxLum = 1.0f;
+    std::vector<uint8_t> record;
+    meta.serialize(record);
+    const uint8_t header[] = {'L', 'H', 'D', 'R', 0x00, 0x02, 36, 0};
+    const uint8_t maxLum[] = {0x00, 0x00, 0x80, 0x3F};
+    if (memcmp(&record[0], header, 8) || memcmp(&record[16], maxLum, 4))
+    {
+        fprintf(stderr, "Unexpected byte order of the meta data record\n");
+        failed++;
+    }
+    
+    // A new major version cannot be read
+    record[5] = 3;
+    try
+    {
+        meta.deserialize(&record[0], record.size());
+        fprintf(stderr, "Meta data record of unsupported version accepted\n");
+        failed++;
+    }
+    catch (LumaException &e)
+    {}
+    
+    // Version 1.0, with the mapping as float values
+    {
+        LumaQuantizer quant;
+        quant.setQuantizer(LumaQuantizer::PTF_PSI, 8, LumaQuantizer::CS_LUV, 8, 1e4f, 0.005f);
+        meta.ptfBitDepth = 8;
+        meta.mapping.assign(quant.getMapping(), quant.getMapping() + quant.getSize() + 1);
+        meta.serialize(record);
+        
+        const uint32_t n = meta.mapping.size(), bytes = 4*n;
+        record.resize(36 + bytes);
+        record[4] = 0x00;
+        record[5] = 0x01;
+        record[24] = LumaMetaData::MAPPING_FLOAT;
+        for (int i=0; i<4; i++)
+            record[32+i] = (bytes >> 8*i) & 0xFF;
+        for (uint32_t k=0; k<n; k++)
+        {
+            uint32_t u;
+            memcpy(&u, &meta.mapping[k], 4);
+            for (int i=0; i<4; i++)
+                record[36+4*k+i] = (u >> 8*i) & 0xFF;
+        }
+        
+        LumaMetaData res;
+        if (!res.deserialize(&record[0], record.size()) || res.mapping != meta.mapping)
+        {
+            fprintf(stderr, "Meta data record of version 1.0 not parsed correctly\n");
+            failed++;
+        }
+        
+        // Version 1.0 had no other encodings of the mapping
+        record[24] = LumaMetaData::MAPPING_DELTA;
+        if (res.deserialize(&record[0], record.size()))
+        {
+            fprintf(stderr, "Delta coded mapping accepted in version 1.0\n");
+            failed++;
+        }
+    }
+    
+    // Legacy attachments
+    LumaMetaData legacy;
+    const unsigned int ptf = LumaQuantizer::PTF_LOG, bitDepth = 10;
+    const float range[] = {4000.0f, 0.05f};
+    legacy.deserializeLegacy(430, (const uint8_t*)&bitDepth, 4);
+    legacy.deserializeLegacy(432, (const uint8_t*)&ptf, 4);
+    legacy.deserializeLegacy(436, (const uint8_t*)range, 8);
+    if (legacy.ptfBitDepth != bitDepth || legacy.ptf != LumaQuantizer::PTF_LOG ||
+        legacy.maxLum != range[0] || legacy.minLum != range[1])
+    {
+        fprintf(stderr, "Legacy meta data not parsed correctly\n");
+        failed++;
+    }
+    
+    return failed ? 1 : 0;
+}
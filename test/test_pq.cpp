@@ -0,0 +1,60 @@
+#include <luma_quantizer.h>
+
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <algorithm>
+
+// Accuracy and speed of the tabulated PQ transformation of the YCbCr color
+// space, compared to the reference transformPQ(). The error is measured in
+// code values at 12 bits, and has to be less than half a code value
+int main()
+{
+    const float maxError = 0.5f, codes = 4095.0f;
+    const unsigned int samples = 1000000;
+    
+    LumaQuantizer quant;
+    quant.setQuantizer(LumaQuantizer::PTF_PQ, 11, LumaQuantizer::CS_YCBCR, 8, 10000.0f, 0.005f);
+    
+    // Encoding, over luminances 1e-6 - 1e4 cd/m^2
+    float encError = 0.0f;
+    for (unsigned int i = 0; i <= samples; i++)
+    {
+        const float l = powf(10.0f, -6.0f + 10.0f*i/samples);
+        encError = std::max(encError, codes*fabsf(quant.encodePQ(l) - quant.transformPQ(l, 1)));
+    }
+    
+    // Decoding, over PQ values 0 - 1, with the error measured after encoding
+    float decError = 0.0f;
+    for (unsigned int i = 0; i <= samples; i++)
+    {
+        const float v = (float)i/samples;
+        decError = std::max(decError, codes*fabsf(quant.transformPQ(quant.decodePQ(v), 1) -
+                                                  quant.transformPQ(quant.transformPQ(v, 0), 1)));
+    }
+    
+    printf("Max error at 12 bits: encoding %f, decoding %f code values.\n", encError, decError);
+    
+    // Throughput
+    std::chrono::high_resolution_clock::time_point t0, t1, t2;
+    float sum0 = 0.0f, sum1 = 0.0f;
+    t0 = std::chrono::high_resolution_clock::now();
+    for (unsigned int i = 0; i < samples; i++)
+        sum0 += quant.transformPQ(quant.transformPQ(10000.0f*i/samples, 1), 0);
+    t1 = std::chrono::high_resolution_clock::now();
+    for (unsigned int i = 0; i < samples; i++)
+        sum1 += quant.decodePQ(quant.encodePQ(10000.0f*i/samples));
+    t2 = std::chrono::high_resolution_clock::now();
+    
+    const double ref = std::chrono::duration<double>(t1 - t0).count(), fast = std::chrono::duration<double>(t2 - t1).count();
+    printf("Encoding + decoding: reference %.1f ns, tables %.1f ns (%.1fx), checksum %g/%g.\n",
+           1e9*ref/samples, 1e9*fast/samples, ref/fast, sum0, sum1);
+    
+    if (!(encError < maxError && decError < maxError))
+    {
+        fprintf(stderr, "Tabulated PQ transformation differs from the reference\n");
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,466 @@
+/**
+ * This file is part of the LumaHDRv package.
+ * -----------------------------------------------------------------------------
+ * Copyright (c) 2015, The LumaHDRv authors.
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ * -----------------------------------------------------------------------------
+ *
+ * \author Gabriel Eilertsen, gabriel.eilertsen@liu.se
+ *
+ * \date Oct 18 2026
+ */
+
+#include <luma_encoder.h>
+#include <luma_decoder.h>
+#include "exr_interface.h"
+#include "luma_exception.h"
+#include "arg_parser.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+// Test options
+struct TestData
+{
+    TestData() : frames(6), size("160x96"), startFrame(1), endFrame(6), tmpDir("."),
+                 update(false), psnrTolerance(0.5f), errorTolerance(0.25f), minPsnr(30.0f), minFps(0.0f)
+    {}
+    
+    unsigned int frames;
+    std::string size, inputFrames;
+    unsigned int startFrame, endFrame;
+    std::string tmpDir, referenceFile;
+    bool update;
+    float psnrTolerance, errorTolerance, minPsnr, minFps;
+};
+
+// One point in the PTF x color space x profile/bit depth matrix
+struct TestConfig
+{
+    LumaQuantizer::ptf_t ptf;
+    LumaQuantizer::colorSpace_t colorSpace;
+    unsigned int profile, bitDepth;
+};
+
+// Round-trip result of one configuration. Configurations that are known to
+// fall below the minimum quality are marked as known bad in the reference
+struct TestResult
+{
+    TestResult() : frames(0), logPsnr(0.0), maxRelError(0.0), encFps(0.0), decFps(0.0), knownBad(false)
+    {}
+    
+    unsigned int frames;
+    double logPsnr, maxRelError, encFps, decFps;
+    bool knownBad;
+};
+
+const char *ptfNames[] = {"PSI", "PQ", "LOG", "HDRVDP", "LINEAR"};
+const char *csNames[] = {"LUV", "RGB", "YCBCR", "XYZ"};
+
+// Luminance of an RGB pixel, clamped to the range of the encoder
+inline double luminance(const LumaFrame &frame, size_t i, double minLum, double maxLum)
+{
+    double Y = 0.2126*frame.getChannel(0)[i] + 0.7152*frame.getChannel(1)[i] + 0.0722*frame.getChannel(2)[i];
+    return std::min(maxLum, std::max(minLum, Y));
+}
+
+// Accumulated log luminance error and relative error over a sequence. The
+// relative error is measured against at least 1 cd/m^2, so that the darkest
+// pixels, where no PTF is accurate in relative terms, do not dominate
+class ErrorMeasure
+{
+public:
+    ErrorMeasure(double minLum, double maxLum) : m_minLum(minLum), m_maxLum(maxLum), m_sse(0.0), m_maxRel(0.0), m_pixels(0)
+    {}
+    
+    void add(const LumaFrame &ref, const LumaFrame &dec)
+    {
+        if (ref.width != dec.width || ref.height != dec.height || dec.channels < 3)
+            throw LumaException("Decoded frame does not match the reference");
+        
+        for (size_t i=0; i<(size_t)ref.width*ref.height; i++)
+        {
+            double Yr = luminance(ref, i, m_minLum, m_maxLum), Yd = luminance(dec, i, m_minLum, m_maxLum);
+            if (Yd != Yd) // NaN
+                Yd = m_maxLum*10.0;
+            
+            double d = log10(Yd) - log10(Yr);
+            m_sse += d*d;
+            m_maxRel = std::max(m_maxRel, fabs(Yd - Yr) / std::max(Yr, 1.0));
+        }
+        m_pixels += (size_t)ref.width*ref.height;
+    }
+    
+    // PSNR of log10 luminance, with the dynamic range of the encoder as peak
+    double logPsnr() const
+    {
+        double mse = m_pixels ? m_sse / m_pixels : 0.0;
+        double peak = log10(m_maxLum) - log10(m_minLum);
+        return mse > 0.0 ? 10.0*log10(peak*peak / mse) : 999.0;
+    }
+    
+    double maxRelError() const { return m_maxRel; }
+
+private:
+    double m_minLum, m_maxLum, m_sse, m_maxRel;
+    size_t m_pixels;
+};
+
+// Synthetic test pattern with sharp edges, that is shifted horizontally between frames
+void patternFrame(LumaFrame &frame, LumaFrame &pattern, unsigned int f)
+{
+    frame.resize(pattern.width, pattern.height, pattern.channels);
+    
+    const unsigned int w = pattern.width, shift = (8*f) % w;
+    for (unsigned int c=0; c<pattern.channels; c++)
+        for (unsigned int y=0; y<pattern.height; y++)
+        {
+            const float *src = pattern.getChannel(c) + (size_t)y*w;
+            float *dest = frame.getChannel(c) + (size_t)y*w;
+            memcpy(dest, src + shift, (w-shift)*sizeof(float));
+            memcpy(dest + w - shift, src, shift*sizeof(float));
+        }
+}
+
+// Smooth gradient over the full luminance range, with varying chromaticity.
+// Reveals banding and color shifts that the sharp test pattern hides
+void gradientFrame(LumaFrame &frame, unsigned int w, unsigned int h, unsigned int f)
+{
+    frame.resize(w, h, 3);
+    
+    for (size_t y=0; y<h; y++)
+        for (size_t x=0; x<w; x++)
+        {
+            float t = (float)((x + 4*f) % w) / w, s = (float)y / h;
+            float L = 0.01f * powf(10.0f, 6.0f*t);
+            frame.getChannel(0)[x+y*w] = L * (1.0f + 0.5f*sinf(6.2832f*s));
+            frame.getChannel(1)[x+y*w] = L;
+            frame.getChannel(2)[x+y*w] = L * (1.0f + 0.5f*cosf(6.2832f*s));
+        }
+}
+
+// Provider of the frames of one test sequence
+class Sequence
+{
+public:
+    Sequence(std::string name, const TestData &td, unsigned int w, unsigned int h) :
+        m_name(name), m_td(td), m_width(w), m_height(h)
+    {
+        if (m_name == "pattern")
+            ExrInterface::testFrame(m_pattern, w, h);
+    }
+    
+    std::string name() const { return m_name; }
+    
+    unsigned int frames() const
+    {
+        return m_name == "input" ? m_td.endFrame - m_td.startFrame + 1 : m_td.frames;
+    }
+    
+    void getFrame(LumaFrame &frame, unsigned int f)
+    {
+        if (m_name == "pattern")
+            patternFrame(frame, m_pattern, f);
+        else if (m_name == "gradient")
+            gradientFrame(frame, m_width, m_height, f);
+        else
+        {
+            char str[500];
+            snprintf(str, 500, m_td.inputFrames.c_str(), m_td.startFrame + f);
+            ExrInterface::readFrame(str, frame);
+        }
+    }
+
+private:
+    std::string m_name;
+    const TestData &m_td;
+    unsigned int m_width, m_height;
+    LumaFrame m_pattern;
+};
+
+// Encode and decode a sequence with one configuration, and measure the error
+TestResult roundTrip(Sequence &seq, const TestConfig &tc, const TestData &td)
+{
+    TestResult res;
+    std::string videoFile = td.tmpDir + "/test_roundtrip.mkv";
+    LumaFrame frame;
+    float minLum, maxLum;
+    
+    // Encoding
+    {
+        LumaEncoder encoder;
+        LumaEncoderParams params = encoder.getParams();
+        params.ptf = tc.ptf;
+        params.colorSpace = tc.colorSpace;
+        params.profile = tc.profile;
+        params.bitDepth = tc.bitDepth;
+        params.ptfBitDepth = std::min(11u, tc.bitDepth);
+        params.colorBitDepth = 8;
+        encoder.setParams(params);
+        minLum = params.minLum;
+        maxLum = params.maxLum;
+        
+        double ns = 0.0;
+        for (unsigned int f=0; f<seq.frames(); f++)
+        {
+            seq.getFrame(frame, f);
+            
+            uint64_t start = lumaTimeNs();
+            if (!encoder.initialized())
+                encoder.initialize(videoFile.c_str(), frame.width, frame.height);
+            encoder.encode(&frame);
+            ns += lumaTimeNs() - start;
+        }
+        uint64_t start = lumaTimeNs();
+        encoder.finish();
+        ns += lumaTimeNs() - start;
+        res.encFps = ns > 0.0 ? 1e9*seq.frames()/ns : 0.0;
+    }
+    
+    // Decoding, and comparison to the input frames
+    {
+        ErrorMeasure err(minLum, maxLum);
+        LumaFrame *dec;
+        double ns = 0.0;
+        
+        uint64_t start = lumaTimeNs();
+        LumaDecoder decoder(videoFile.c_str(), false);
+        ns += lumaTimeNs() - start;
+        
+        while (1)
+        {
+            start = lumaTimeNs();
+            dec = decoder.decode();
+            ns += lumaTimeNs() - start;
+            
+            if (dec == NULL || res.frames >= seq.frames())
+                break;
+            
+            seq.getFrame(frame, res.frames++);
+            err.add(frame, *dec);
+        }
+        
+        res.decFps = ns > 0.0 ? 1e9*res.frames/ns : 0.0;
+        res.logPsnr = err.logPsnr();
+        res.maxRelError = err.maxRelError();
+    }
+    remove(videoFile.c_str());
+    
+    return res;
+}
+
+// Key of a configuration, as used in the reference file
+std::string configKey(const std::string &seq, const TestConfig &tc)
+{
+    char str[200];
+    snprintf(str, 200, "%s %s %s %u %u", seq.c_str(), ptfNames[tc.ptf], csNames[tc.colorSpace], tc.profile, tc.bitDepth);
+    return str;
+}
+
+// Read the reference results, as lines of "<sequence> <ptf> <cs> <profile> <bit depth> <log-PSNR> <max rel. error> [xfail]"
+std::map<std::string, TestResult> readReference(const std::string &file)
+{
+    std::map<std::string, TestResult> ref;
+    
+    FILE *fp = fopen(file.c_str(), "r");
+    if (fp == NULL)
+        return ref;
+    
+    char line[500], seq[100], ptf[100], cs[100], flag[100];
+    unsigned int profile, bitDepth;
+    while (fgets(line, 500, fp) != NULL)
+    {
+        if (line[0] == '#')
+            continue;
+        
+        TestResult r;
+        int n = sscanf(line, "%99s %99s %99s %u %u %lf %lf %99s", seq, ptf, cs, &profile, &bitDepth, &r.logPsnr, &r.maxRelError, flag);
+        if (n != 7 && n != 8)
+            continue;
+        if (n == 8 && strcmp(flag, "xfail"))
+            throw LumaException("Unknown flag in reference file");
+        r.knownBad = n == 8;
+        
+        char str[500];
+        snprintf(str, 500, "%s %s %s %u %u", seq, ptf, cs, profile, bitDepth);
+        ref[str] = r;
+    }
+    fclose(fp);
+    
+    return ref;
+}
+
+// Parse parameter options from command line
+bool setParams(int argc, char* argv[], TestData *td)
+{
+    // Application usage info
+    std::string info = std::string("test_roundtrip -- Encode, decode and measure the quality of HDR sequences, over all PTFs, color spaces and profiles\n\n") +
+                       std::string("Usage: test_roundtrip --reference <reference_file> --tmp-dir <directory>\n");
+    std::string postInfo = std::string("\nExample: test_roundtrip -r roundtrip_reference.txt -i frames_%05d.exr -s 1 -e 10\n\n") +
+                           std::string("The test fails if the quality of any configuration falls below the reference results,\n") +
+                           std::string("or below the minimum log-PSNR unless it is marked with xfail in the reference file.");
+    ArgParser argHolder(info, postInfo);
+    
+    argHolder.add(&td->frames,         "--frames",          "-f",  "Number of frames of the synthetic sequences", (unsigned int)(1), (unsigned int)(1000));
+    argHolder.add(&td->size,           "--size",            "-sz", "Size of the synthetic sequences (WxH)");
+    argHolder.add(&td->inputFrames,    "--input",           "-i",  "Real HDR sequence to test, as EXR frames (e.g. frames_%05d.exr)");
+    argHolder.add(&td->startFrame,     "--start-frame",     "-s",  "First frame of the input sequence");
+    argHolder.add(&td->endFrame,       "--end-frame",       "-e",  "Last frame of the input sequence");
+    argHolder.add(&td->referenceFile,  "--reference",       "-r",  "File with reference results to compare with");
+    argHolder.add(&td->update,         "--update",          "-u",  "Write the results to the reference file, instead of comparing");
+    argHolder.add(&td->tmpDir,         "--tmp-dir",         "-t",  "Directory for temporary video files");
+    argHolder.add(&td->psnrTolerance,  "--psnr-tolerance",  "-pt", "Allowed decrease in log-PSNR from the reference (dB)", 0.0f, 100.0f);
+    argHolder.add(&td->errorTolerance, "--error-tolerance", "-et", "Allowed relative increase in max error from the reference", 0.0f, 100.0f);
+    argHolder.add(&td->minPsnr,        "--min-psnr",        "-mp", "Minimum log-PSNR of configurations not marked as known bad (dB)", 0.0f, 1000.0f);
+    argHolder.add(&td->minFps,         "--min-fps",         "-mf", "Minimum encoding and decoding frame rate", 0.0f, 1e6f);
+    
+    if (!argHolder.read(argc, argv))
+        return 0;
+    
+    if (td->endFrame < td->startFrame)
+        throw ParserException("Last frame of the input sequence must be after the first frame");
+    
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    TestData td;
+    
+    try
+    {
+        if (!setParams(argc, argv, &td))
+            return 1;
+        
+        unsigned int w, h;
+        if (sscanf(td.size.c_str(), "%ux%u", &w, &h) != 2 || !w || !h || w % 2 || h % 2)
+            throw ParserException("Invalid size of synthetic sequences");
+        
+        // When updating, the known bad markers of the reference are kept
+        std::map<std::string, TestResult> ref;
+        if (td.referenceFile.size())
+            ref = readReference(td.referenceFile);
+        
+        FILE *out = NULL;
+        if (td.update)
+        {
+            if (!td.referenceFile.size() || (out = fopen(td.referenceFile.c_str(), "w")) == NULL)
+                throw LumaException("Unable to open reference file for writing");
+            fprintf(out, "# Reference results of test_roundtrip, %u frames at %ux%u\n", td.frames, w, h);
+            fprintf(out, "# <sequence> <ptf> <color space> <profile> <bit depth> <log-PSNR> <max rel. error> [xfail]\n");
+            fprintf(out, "# xfail marks configurations that are known to be below the minimum log-PSNR\n");
+        }
+        
+        std::vector<Sequence*> sequences;
+        sequences.push_back(new Sequence("pattern", td, w, h));
+        sequences.push_back(new Sequence("gradient", td, w, h));
+        if (td.inputFrames.size())
+            sequences.push_back(new Sequence("input", td, w, h));
+        
+        // Profiles 0-1 are 8 bit, and 2-3 high bit depth
+        const unsigned int profiles[][2] = {{0,8}, {1,8}, {2,10}, {2,12}, {3,12}};
+        
+        unsigned int nrTests = 0, nrFailed = 0;
+        printf("%-10s %-8s %-6s %-3s %-3s %9s %11s %9s %9s  %s\n",
+               "sequence", "ptf", "cs", "p", "bd", "logPSNR", "maxRelErr", "enc fps", "dec fps", "status");
+        for (size_t s=0; s<sequences.size(); s++)
+            for (unsigned int p=0; p<5; p++)
+                for (unsigned int c=0; c<4; c++)
+                    for (unsigned int b=0; b<5; b++)
+                    {
+                        TestConfig tc = {(LumaQuantizer::ptf_t)p, (LumaQuantizer::colorSpace_t)c, profiles[b][0], profiles[b][1]};
+                        std::string key = configKey(sequences[s]->name(), tc);
+                        
+                        TestResult res = roundTrip(*sequences[s], tc, td);
+                        
+                        // Compare to reference
+                        const bool knownBad = ref.count(key) && ref[key].knownBad;
+                        std::string status = "ok";
+                        if (res.frames != sequences[s]->frames())
+                            status = "FAILED (frame count)";
+                        else if (res.logPsnr != res.logPsnr || res.maxRelError != res.maxRelError)
+                            status = "FAILED (NaN)";
+                        else if (td.minFps > 0.0f && (res.encFps < td.minFps || res.decFps < td.minFps))
+                            status = "FAILED (fps)";
+                        else if (res.logPsnr < td.minPsnr && !knownBad)
+                            status = "FAILED (min log-PSNR)";
+                        else if (ref.count(key) && !td.update)
+                        {
+                            const TestResult &r = ref[key];
+                            if (res.logPsnr < r.logPsnr - td.psnrTolerance)
+                                status = "FAILED (log-PSNR)";
+                            else if (res.maxRelError > r.maxRelError*(1.0f + td.errorTolerance) + 1e-3)
+                                status = "FAILED (max error)";
+                        }
+                        else if (ref.size() && !td.update)
+                            status = "no reference";
+                        
+                        if (knownBad && status == "ok")
+                            status = res.logPsnr < td.minPsnr ? "known bad" : "known bad, but passed";
+                        
+                        nrTests++;
+                        if (status.compare(0, 6, "FAILED") == 0)
+                            nrFailed++;
+                        
+                        printf("%-10s %-8s %-6s %-3u %-3u %9.2f %11.4f %9.1f %9.1f  %s\n",
+                               sequences[s]->name().c_str(), ptfNames[p], csNames[c], tc.profile, tc.bitDepth,
+                               res.logPsnr, res.maxRelError, res.encFps, res.decFps, status.c_str());
+                        fflush(stdout);
+                        
+                        if (out != NULL)
+                            fprintf(out, "%s %.2f %.4f%s\n", key.c_str(), res.logPsnr, res.maxRelError, knownBad ? " xfail" : "");
+                    }
+        
+        for (size_t s=0; s<sequences.size(); s++)
+            delete sequences[s];
+        if (out != NULL)
+            fclose(out);
+        
+        printf("\n%u of %u configurations failed.\n", nrFailed, nrTests);
+        if (nrFailed)
+            return 1;
+    }
+    catch (ParserException &e)
+    {
+        fprintf(stderr, "\ntest_roundtrip input error: %s\n", e.what());
+        return 1;
+    }
+    catch (std::exception &e)
+    {
+        fprintf(stderr, "\ntest_roundtrip error: %s\n", e.what());
+        return 1;
+    }
+    
+    return 0;
+}
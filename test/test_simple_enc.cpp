@@ -46,12 +46,11 @@ int main(int argc, char* argv[])
     encoder.setParams(params);
     
     char str[500];
+    LumaFrame frame;
     for (int f = startFrame; f <= endFrame; f++)
     {
         printf("Encoding frame %d.\n", f );
         
-        LumaFrame frame;
-        
         if (hdrFrames != NULL)
         {
             sprintf(str, hdrFrames, f);